@@ -0,0 +1,117 @@
+#include "Arena.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+static size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+void* HugePageArena::allocate(size_t bytes) {
+    size_t length = roundUp(bytes, HUGE_PAGE_SIZE);
+
+    // Over-map by one huge page so the block can start on a 2 MB boundary
+    void* raw = mmap(nullptr, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) throw std::bad_alloc();
+
+    uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = roundUp(start, HUGE_PAGE_SIZE);
+    size_t head = aligned - start;
+    if (head > 0) munmap(raw, head);
+    munmap(reinterpret_cast<void*>(aligned + length), HUGE_PAGE_SIZE - head);
+
+    char* data = reinterpret_cast<char*>(aligned);
+    madvise(data, length, MADV_HUGEPAGE);  // Best effort; THP may be disabled
+
+    return data;
+}
+
+void HugePageArena::deallocate(void* ptr, size_t bytes) noexcept {
+    if (ptr) munmap(ptr, roundUp(bytes, HUGE_PAGE_SIZE));
+}
+
+void HugePageArena::pinToWorkerCpu(size_t worker, size_t workerCount) {
+    // Snapshot the CPUs we may run on before any thread has been pinned
+    static const std::vector<int> cpus = [] {
+        std::vector<int> allowed;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) allowed.push_back(cpu);
+            }
+        }
+        return allowed;
+    }();
+    if (cpus.empty()) return;
+
+    // Spread workers evenly so consecutive chunks share a socket
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[(worker % workerCount) * cpus.size() / workerCount], &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+FrameArena& FrameArena::local() {
+    static thread_local FrameArena arena;
+    return arena;
+}
+
+FrameArena::~FrameArena() {
+    for (const auto& block : blocks) {
+        HugePageArena::deallocate(block.data, block.size);
+    }
+}
+
+void FrameArena::addBlock(size_t minBytes) {
+    size_t size = std::max(BLOCK_SIZE, roundUp(minBytes, BLOCK_SIZE));
+    char* data = static_cast<char*>(HugePageArena::allocate(size));
+    blocks.push_back({data, size});
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    if (blocks.empty()) addBlock(bytes + alignment);
+
+    while (true) {
+        const Block& block = blocks[current];
+        size_t start = roundUp(offset, alignment);
+        if (start + bytes <= block.size) {
+            offset = start + bytes;
+            return block.data + start;
+        }
+        if (current + 1 < blocks.size()) {
+            ++current;
+        } else {
+            addBlock(bytes + alignment);
+            current = blocks.size() - 1;
+        }
+        offset = 0;
+    }
+}
+
+void FrameArena::reset() {
+    // Coalesce so a frame like the last one fits in a single block
+    if (blocks.size() > 1) {
+        size_t total = 0;
+        for (const auto& block : blocks) {
+            total += block.size;
+            HugePageArena::deallocate(block.data, block.size);
+        }
+        blocks.clear();
+        addBlock(total);
+    }
+    current = 0;
+    offset = 0;
+}
+
+size_t FrameArena::bytesInUse() const {
+    size_t used = offset;
+    for (size_t i = 0; i < current; ++i) {
+        used += blocks[i].size;
+    }
+    return used;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Large, long-lived allocations (particle storage) come straight from mmap,
+// aligned to and advised for transparent huge pages. Pages are left
+// unfaulted: Linux places a page on the NUMA node of the thread that first
+// writes it, so the owner of the memory decides who touches it first (see
+// ThreadPool::firstTouch).
+class HugePageArena {
+public:
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    static constexpr size_t PAGE_SIZE = 4096;
+
+    static bool isLarge(size_t bytes) { return bytes >= HUGE_PAGE_SIZE; }
+    static void* allocate(size_t bytes);
+    static void deallocate(void* ptr, size_t bytes) noexcept;
+
+    // Pins the calling thread to the CPU that worker index of workerCount
+    // maps to, spreading consecutive workers evenly over the allowed CPUs
+    static void pinToWorkerCpu(size_t worker, size_t workerCount);
+};
+
+// Per-thread bump allocator for buffers that only live for one frame
+// (spatial hash cells, neighbor lists). Everything is released at once by
+// reset() at the end of Simulation::update; individual frees are no-ops.
+class FrameArena {
+public:
+    static constexpr size_t BLOCK_SIZE = HugePageArena::HUGE_PAGE_SIZE;
+
+    static FrameArena& local();
+
+    FrameArena() = default;
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment);
+    void reset();
+    size_t bytesInUse() const;
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    void addBlock(size_t minBytes);
+
+    std::vector<Block> blocks;
+    size_t current = 0;   // Block being bumped
+    size_t offset = 0;    // Bump position inside it
+};
+
+template<typename T>
+struct FrameAllocator {
+    using value_type = T;
+
+    FrameAllocator() noexcept = default;
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n > std::size_t(-1) / sizeof(T)) throw std::bad_alloc();
+        return static_cast<T*>(FrameArena::local().allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t) noexcept {}
+};
+
+template<typename T, typename U>
+bool operator==(const FrameAllocator<T>&, const FrameAllocator<U>&) { return true; }
+
+template<typename T, typename U>
+bool operator!=(const FrameAllocator<T>&, const FrameAllocator<U>&) { return false; }
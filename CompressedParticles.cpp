@@ -0,0 +1,338 @@
+#include "CompressedParticles.hpp"
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+static constexpr uint32_t MOVED_MARK = UINT32_MAX;
+static constexpr int64_t CELL_UNITS = int64_t(1) << CompressedParticles::FRACTION_BITS;
+static constexpr int64_t OFFSET_MASK = CELL_UNITS - 1;
+
+int64_t CompressedParticles::toFixed(float value) const {
+    return static_cast<int64_t>(std::llrint(static_cast<double>(value) * fixedScale));
+}
+
+void CompressedParticles::assign(const std::vector<Particle, AlignedAllocator<Particle>>& particles,
+                                 float cellSize) {
+    count = particles.size();
+    this->cellSize = cellSize;
+    fixedScale = FIXED_POINT_SCALE / cellSize;
+
+    // Split every position into its cell and the offset inside it
+    std::vector<int64_t> fixedX(count), fixedY(count);
+    for (size_t i = 0; i < count; ++i) {
+        const float* pos = (const float*)&particles[i].position;
+        fixedX[i] = toFixed(pos[0]);
+        fixedY[i] = toFixed(pos[1]);
+    }
+
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        int64_t ya = fixedY[a] >> FRACTION_BITS, yb = fixedY[b] >> FRACTION_BITS;
+        if (ya != yb) return ya < yb;
+        return (fixedX[a] >> FRACTION_BITS) < (fixedX[b] >> FRACTION_BITS);
+    });
+
+    // Pad to whole SIMD blocks so the kernels never need a scalar tail
+    size_t padded = (count + LANES - 1) / LANES * LANES;
+    offX.assign(padded, 0); offY.assign(padded, 0);
+    velX.assign(padded, 0); velY.assign(padded, 0);
+    radius.assign(padded, 0);
+    ids.assign(padded, 0);
+    cellX.clear(); cellY.clear(); cellStart.clear();
+
+    for (size_t k = 0; k < count; ++k) {
+        uint32_t i = order[k];
+        int32_t x = static_cast<int32_t>(fixedX[i] >> FRACTION_BITS);
+        int32_t y = static_cast<int32_t>(fixedY[i] >> FRACTION_BITS);
+        if (cellX.empty() || cellX.back() != x || cellY.back() != y) {
+            cellX.push_back(x);
+            cellY.push_back(y);
+            cellStart.push_back(static_cast<uint32_t>(k));
+        }
+
+        const float* vel = (const float*)&particles[i].velocity;
+        offX[k] = static_cast<uint16_t>(fixedX[i] & OFFSET_MASK);
+        offY[k] = static_cast<uint16_t>(fixedY[i] & OFFSET_MASK);
+        velX[k] = _cvtss_sh(vel[0], _MM_FROUND_TO_NEAREST_INT);
+        velY[k] = _cvtss_sh(vel[1], _MM_FROUND_TO_NEAREST_INT);
+        radius[k] = _cvtss_sh(particles[i].radius, _MM_FROUND_TO_NEAREST_INT);
+        ids[k] = i;
+    }
+    cellStart.push_back(static_cast<uint32_t>(count));
+}
+
+void CompressedParticles::decodeInCell(size_t index, size_t cell, Particle& out) const {
+    constexpr float offsetScale = 1.0f / FIXED_POINT_SCALE;
+    out = Particle{};
+    out.position = _mm_setr_ps((cellX[cell] + offX[index] * offsetScale) * cellSize,
+                               (cellY[cell] + offY[index] * offsetScale) * cellSize,
+                               0, 0);
+    out.velocity = _mm_setr_ps(_cvtsh_ss(velX[index]), _cvtsh_ss(velY[index]), 0, 0);
+    out.radius = _cvtsh_ss(radius[index]);
+    out.mass = out.radius * out.radius;  // Simulation::massFor in 2D
+}
+
+void CompressedParticles::decode(size_t index, Particle& out) const {
+    decodeInCell(index, particleCell[index], out);
+}
+
+void CompressedParticles::decodeAll(std::vector<Particle, AlignedAllocator<Particle>>& out) const {
+    out.resize(count);
+    for (size_t c = 0; c < cellCount(); ++c) {
+        for (uint32_t i = cellBegin(c); i < cellEnd(c); ++i) {
+            decodeInCell(i, c, out[ids[i]]);
+        }
+    }
+}
+
+void CompressedParticles::storeVelocity(size_t index, const __m128& velocity) {
+    const float* vel = (const float*)&velocity;
+    velX[index] = _cvtss_sh(vel[0], _MM_FROUND_TO_NEAREST_INT);
+    velY[index] = _cvtss_sh(vel[1], _MM_FROUND_TO_NEAREST_INT);
+}
+
+void CompressedParticles::releaseFrameStorage() {
+    particleCell = FrameIndices();
+}
+
+void CompressedParticles::bindCells() {
+    particleCell.assign(offX.size(), 0);
+    for (size_t c = 0; c < cellCount(); ++c) {
+        std::fill(particleCell.begin() + cellBegin(c), particleCell.begin() + cellEnd(c),
+                  static_cast<uint32_t>(c));
+    }
+}
+
+static inline __m256 loadHalf(const uint16_t* src) {
+    return _mm256_cvtph_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(src)));
+}
+
+static inline void storeHalf(uint16_t* dst, __m256 v) {
+    _mm_store_si128(reinterpret_cast<__m128i*>(dst),
+                    _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+}
+
+static inline __m256i loadOffset(const uint16_t* src) {
+    return _mm256_cvtepu16_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(src)));
+}
+
+// Stores the low 16 bits of each lane; the values are already masked to 0..65535
+static inline void storeOffset(uint16_t* dst, __m256i v) {
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), 0x08);
+    _mm_store_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(packed));
+}
+
+void CompressedParticles::integrate(float deltaTime, float gravity, float dragCoefficient) {
+    if (count == 0) return;
+    bindCells();
+
+    const __m256 grav = _mm256_set1_ps(gravity);
+    // Displacement goes straight to fixed point so position updates are exact integer adds
+    const __m256 dtFixed = _mm256_set1_ps(deltaTime * fixedScale);
+    const __m256 damping = _mm256_set1_ps(1.0f - dragCoefficient * deltaTime);
+    const __m256i offsetMask = _mm256_set1_epi32(static_cast<int>(OFFSET_MASK));
+    const int* cellXs = cellX.data();
+    const int* cellYs = cellY.data();
+
+    MoveList moved;
+    alignas(32) int32_t newX[LANES];
+    alignas(32) int32_t newY[LANES];
+
+    for (size_t i = 0; i < offX.size(); i += LANES) {
+        __m256 vx = loadHalf(&velX[i]);
+        __m256 vy = _mm256_add_ps(loadHalf(&velY[i]), grav);
+
+        // Offsets leave [0, 65536) when a particle crosses into another cell;
+        // the arithmetic shift is the signed cell step
+        __m256i ox = _mm256_add_epi32(loadOffset(&offX[i]), _mm256_cvtps_epi32(_mm256_mul_ps(vx, dtFixed)));
+        __m256i oy = _mm256_add_epi32(loadOffset(&offY[i]), _mm256_cvtps_epi32(_mm256_mul_ps(vy, dtFixed)));
+        __m256i stepX = _mm256_srai_epi32(ox, FRACTION_BITS);
+        __m256i stepY = _mm256_srai_epi32(oy, FRACTION_BITS);
+        storeOffset(&offX[i], _mm256_and_si256(ox, offsetMask));
+        storeOffset(&offY[i], _mm256_and_si256(oy, offsetMask));
+
+        storeHalf(&velX[i], _mm256_mul_ps(vx, damping));
+        storeHalf(&velY[i], _mm256_mul_ps(vy, damping));
+
+        __m256i stayed = _mm256_cmpeq_epi32(_mm256_or_si256(stepX, stepY), _mm256_setzero_si256());
+        int changed = ~_mm256_movemask_ps(_mm256_castsi256_ps(stayed)) & 0xFF;
+        if (!changed) continue;
+
+        __m256i cell = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&particleCell[i]));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(newX),
+            _mm256_add_epi32(_mm256_i32gather_epi32(cellXs, cell, 4), stepX));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(newY),
+            _mm256_add_epi32(_mm256_i32gather_epi32(cellYs, cell, 4), stepY));
+        for (; changed; changed &= changed - 1) {
+            int lane = __builtin_ctz(changed);
+            if (i + lane < count) {
+                moved.push_back({newX[lane], newY[lane], static_cast<uint32_t>(i + lane)});
+            }
+        }
+    }
+
+    // Padding lanes picked up gravity; keep them at rest
+    for (size_t i = count; i < velX.size(); ++i) {
+        velX[i] = 0;
+        velY[i] = 0;
+    }
+
+    if (!moved.empty()) rebin(moved);
+}
+
+template<typename T, typename Alloc>
+static void permute(std::vector<T, Alloc>& values, const std::vector<uint32_t, FrameAllocator<uint32_t>>& order) {
+    std::vector<T, FrameAllocator<T>> source(values.begin(), values.begin() + order.size());
+    for (size_t k = 0; k < order.size(); ++k) {
+        values[k] = source[order[k]];
+    }
+}
+
+void CompressedParticles::rebin(MoveList& moved) {
+    if (particleCell.size() != offX.size()) bindCells();
+
+    std::sort(moved.begin(), moved.end(), [](const Move& a, const Move& b) {
+        if (a.y != b.y) return a.y < b.y;
+        if (a.x != b.x) return a.x < b.x;
+        return a.index < b.index;
+    });
+    for (const Move& move : moved) {
+        particleCell[move.index] = MOVED_MARK;
+    }
+
+    // Merge the particles that stayed (already in cell order) with the sorted
+    // movers; order[k] is the old index of the particle that ends up at k
+    FrameIndices order;
+    order.reserve(count);
+    std::vector<int32_t, FrameAllocator<int32_t>> newX, newY;
+    FrameIndices newStart;
+    newX.reserve(cellCount() + moved.size());
+    newY.reserve(cellCount() + moved.size());
+    newStart.reserve(cellCount() + moved.size() + 1);
+    auto emit = [&](int32_t x, int32_t y, uint32_t index) {
+        if (newX.empty() || newX.back() != x || newY.back() != y) {
+            newX.push_back(x);
+            newY.push_back(y);
+            newStart.push_back(static_cast<uint32_t>(order.size()));
+        }
+        order.push_back(index);
+    };
+
+    size_t next = 0;
+    for (size_t c = 0; c < cellCount(); ++c) {
+        int32_t x = cellX[c];
+        int32_t y = cellY[c];
+        for (uint32_t i = cellBegin(c); i < cellEnd(c); ++i) {
+            if (particleCell[i] == MOVED_MARK) continue;
+            while (next < moved.size() &&
+                   (moved[next].y < y || (moved[next].y == y && moved[next].x < x))) {
+                emit(moved[next].x, moved[next].y, moved[next].index);
+                ++next;
+            }
+            emit(x, y, i);
+        }
+    }
+    for (; next < moved.size(); ++next) {
+        emit(moved[next].x, moved[next].y, moved[next].index);
+    }
+    newStart.push_back(static_cast<uint32_t>(count));
+
+    permute(offX, order); permute(offY, order);
+    permute(velX, order); permute(velY, order);
+    permute(radius, order);
+    permute(ids, order);
+
+    cellX.assign(newX.begin(), newX.end());
+    cellY.assign(newY.begin(), newY.end());
+    cellStart.assign(newStart.begin(), newStart.end());
+    bindCells();
+}
+
+void CompressedParticles::applyBounds(float left, float right, float bottom, float top,
+                                      float bounce, float wallFriction) {
+    const int64_t leftFixed = toFixed(left);
+    const int64_t rightFixed = toFixed(right);
+    const int64_t bottomFixed = toFixed(bottom);
+    const int64_t topFixed = toFixed(top);
+    const int64_t leftCell = leftFixed >> FRACTION_BITS;
+    const int64_t rightCell = rightFixed >> FRACTION_BITS;
+    const int64_t bottomCell = bottomFixed >> FRACTION_BITS;
+    const int64_t topCell = topFixed >> FRACTION_BITS;
+
+    MoveList moved;
+    for (size_t c = 0; c < cellCount(); ++c) {
+        // Interior cells can't hold a particle on or past a bound
+        if (cellX[c] > leftCell && cellX[c] < rightCell &&
+            cellY[c] > bottomCell && cellY[c] < topCell) continue;
+
+        for (uint32_t i = cellBegin(c); i < cellEnd(c); ++i) {
+            int64_t px = cellX[c] * CELL_UNITS + offX[i];
+            int64_t py = cellY[c] * CELL_UNITS + offY[i];
+            float vx = _cvtsh_ss(velX[i]);
+            float vy = _cvtsh_ss(velY[i]);
+
+            // X boundaries (left and right)
+            if (px < leftFixed || px > rightFixed) {
+                px = std::clamp(px, leftFixed, rightFixed);
+                vx *= -bounce;
+            }
+
+            // Y boundaries (top and bottom)
+            if (py < bottomFixed || py > topFixed) {
+                py = std::clamp(py, bottomFixed, topFixed);
+                vy *= -bounce;
+            }
+
+            // Particles touching a wall lose some tangential speed
+            if (px == leftFixed || px == rightFixed || py == bottomFixed || py == topFixed) {
+                vx *= wallFriction;
+            }
+
+            offX[i] = static_cast<uint16_t>(px & OFFSET_MASK);
+            offY[i] = static_cast<uint16_t>(py & OFFSET_MASK);
+            velX[i] = _cvtss_sh(vx, _MM_FROUND_TO_NEAREST_INT);
+            velY[i] = _cvtss_sh(vy, _MM_FROUND_TO_NEAREST_INT);
+
+            int32_t x = static_cast<int32_t>(px >> FRACTION_BITS);
+            int32_t y = static_cast<int32_t>(py >> FRACTION_BITS);
+            if (x != cellX[c] || y != cellY[c]) {
+                moved.push_back({x, y, i});
+            }
+        }
+    }
+
+    if (!moved.empty()) rebin(moved);
+}
+
+CompressedParticles::Error CompressedParticles::compare(
+    const std::vector<Particle, AlignedAllocator<Particle>>& reference) const {
+    if (reference.size() != count) {
+        throw std::invalid_argument("Reference particle count does not match compressed storage");
+    }
+
+    Error error;
+    double positionSq = 0.0;
+    double velocitySq = 0.0;
+    Particle decoded;
+    for (size_t c = 0; c < cellCount(); ++c) {
+        for (uint32_t i = cellBegin(c); i < cellEnd(c); ++i) {
+            decodeInCell(i, c, decoded);
+            const Particle& expected = reference[ids[i]];
+            __m128 dp = _mm_sub_ps(decoded.position, expected.position);
+            __m128 dv = _mm_sub_ps(decoded.velocity, expected.velocity);
+            float dpSq = Particle::Simd::dot(dp, dp);
+            float dvSq = Particle::Simd::dot(dv, dv);
+            error.maxPosition = std::max(error.maxPosition, std::sqrt(dpSq));
+            error.maxVelocity = std::max(error.maxVelocity, std::sqrt(dvSq));
+            positionSq += dpSq;
+            velocitySq += dvSq;
+        }
+    }
+    if (count > 0) {
+        error.rmsPosition = static_cast<float>(std::sqrt(positionSq / count));
+        error.rmsVelocity = static_cast<float>(std::sqrt(velocitySq / count));
+    }
+    return error;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <immintrin.h>
+#include "Particle.hpp"
+
+// Compact structure-of-arrays storage for 2D particles. Particles are kept
+// sorted by finest SpatialHash cell; a table of occupied cells holds each
+// cell's integer coordinates and its range of particles, and every particle
+// only stores its 16-bit offset inside the cell. Velocities and radii are
+// IEEE half floats; mass is derived from the radius and charge is not kept.
+// The kernels decompress into AVX registers with F16C and never materialize
+// fp32 particles.
+//
+// 14 bytes per particle (including the id that restores the caller's order)
+// plus 12 per occupied cell, against 20 for position, velocity and radius as
+// fp32 SoA. Positions keep 1/65536 of a cell, velocities and radii about 3
+// significant digits.
+class CompressedParticles {
+public:
+    static constexpr int FRACTION_BITS = 16;
+    static constexpr float FIXED_POINT_SCALE = static_cast<float>(1 << FRACTION_BITS);
+    static constexpr size_t LANES = 8;
+
+    // Error against an fp32 reference, in world units
+    struct Error {
+        float maxPosition = 0.0f;
+        float rmsPosition = 0.0f;
+        float maxVelocity = 0.0f;
+        float rmsVelocity = 0.0f;
+    };
+
+    // Positions are encoded in units of cellSize, which must be the finest
+    // SpatialHash cell so the cell table matches the grid
+    void assign(const std::vector<Particle, AlignedAllocator<Particle>>& particles, float cellSize);
+    // Particle indices are storage order and change whenever particles
+    // cross cells; decodeAll restores the order given to assign
+    void decode(size_t index, Particle& out) const;
+    void decodeAll(std::vector<Particle, AlignedAllocator<Particle>>& out) const;
+    void storeVelocity(size_t index, const __m128& velocity);
+
+    // Same integration as Simulation::updateParticlesBatch, eight particles
+    // per step, followed by re-sorting the particles that changed cells
+    void integrate(float deltaTime, float gravity, float dragCoefficient);
+    // Same response as Simulation::handleScreenBoundaries; only cells that
+    // reach a bound are visited
+    void applyBounds(float left, float right, float bottom, float top,
+                     float bounce, float wallFriction);
+
+    Error compare(const std::vector<Particle, AlignedAllocator<Particle>>& reference) const;
+
+    // The per-particle cell lookup lives in the FrameArena; drop it before reset
+    void releaseFrameStorage();
+
+    size_t size() const { return count; }
+    size_t cellCount() const { return cellX.size(); }
+    int32_t cellXAt(size_t cell) const { return cellX[cell]; }
+    int32_t cellYAt(size_t cell) const { return cellY[cell]; }
+    uint32_t cellBegin(size_t cell) const { return cellStart[cell]; }
+    uint32_t cellEnd(size_t cell) const { return cellStart[cell + 1]; }
+    float radiusOf(size_t index) const { return _cvtsh_ss(radius[index]); }
+    uint32_t idOf(size_t index) const { return ids[index]; }   // Index given to assign
+    static constexpr size_t bytesPerParticle() {
+        return 5 * sizeof(uint16_t) + sizeof(uint32_t);
+    }
+    static constexpr size_t bytesPerCell() { return 2 * sizeof(int32_t) + sizeof(uint32_t); }
+    // The same fields (x, y, vx, vy, radius) as fp32 SoA
+    static constexpr size_t fp32BytesPerParticle() { return 5 * sizeof(float); }
+
+private:
+    using FrameIndices = std::vector<uint32_t, FrameAllocator<uint32_t>>;
+
+    // A particle whose cell changed, with its new cell coordinates
+    struct Move {
+        int32_t x;
+        int32_t y;
+        uint32_t index;
+    };
+    using MoveList = std::vector<Move, FrameAllocator<Move>>;
+
+    void decodeInCell(size_t index, size_t cell, Particle& out) const;
+    void bindCells();
+    void rebin(MoveList& moved);
+    int64_t toFixed(float value) const;
+
+    size_t count = 0;
+    float fixedScale = FIXED_POINT_SCALE;   // Fixed-point units per world unit
+    float cellSize = 1.0f;
+
+    // Occupied cells sorted by (y, x); cellStart has one extra end entry
+    std::vector<int32_t> cellX, cellY;
+    std::vector<uint32_t> cellStart;
+
+    std::vector<uint16_t, AlignedAllocator<uint16_t>> offX, offY, velX, velY, radius;
+    std::vector<uint32_t, AlignedAllocator<uint32_t>> ids;
+
+    // Cell of every particle (padding lanes point at cell 0), rebuilt per frame
+    FrameIndices particleCell;
+};
@@ -5,7 +5,7 @@ Octree::Octree(const char* name) {
     // Implementation of Octree constructor
 }
 
-bool Octree::checkCollision(const __m256& position, float radius) const {
+bool Octree::checkCollision(const float* position, float radius) const {
     // Implementation of collision detection
     return false;
 }
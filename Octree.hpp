@@ -6,7 +6,7 @@
 class Octree {
 public:
     explicit Octree(const char* name);
-    bool checkCollision(const __m256& position, float radius) const;
+    bool checkCollision(const float* position, float radius) const;  // position is (x, y, z)
     
 private:
     struct Node {
@@ -2,19 +2,72 @@
 #include <immintrin.h>
 #include <memory>
 #include <cstddef>
+#include <cstdint>
+#include "Arena.hpp"
 
-struct alignas(32) Particle {
-    __m256 position;  // (x,y,z,_)
-    __m256 velocity;  // (vx,vy,vz,_)
-    float mass;
-    float charge;
+// Register type and kernels for one position or velocity. 2D vectors are
+// (x,y,_,_) in an __m128, so 2D kernels only do 4-wide arithmetic and sum
+// two products per dot; 3D vectors are (x,y,z,_) in an __m256.
+template<int Dim>
+struct ParticleSimd;
+
+template<>
+struct ParticleSimd<2> {
+    using Vector = __m128;
+    
+    static Vector zero() { return _mm_setzero_ps(); }
+    static Vector make(float x, float y, float /*z*/) { return _mm_setr_ps(x, y, 0.0f, 0.0f); }
+    static Vector splat(float value) { return _mm_set1_ps(value); }
+    static Vector add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm_sub_ps(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+    static Vector div(Vector a, Vector b) { return _mm_div_ps(a, b); }
+    static float dot(Vector a, Vector b) {
+        Vector product = _mm_mul_ps(a, b);
+        return _mm_cvtss_f32(_mm_add_ss(product, _mm_movehdup_ps(product)));
+    }
+};
+
+template<>
+struct ParticleSimd<3> {
+    using Vector = __m256;
+    
+    static Vector zero() { return _mm256_setzero_ps(); }
+    static Vector make(float x, float y, float z) { return _mm256_setr_ps(x, y, z, 0, 0, 0, 0, 0); }
+    static Vector splat(float value) { return _mm256_set1_ps(value); }
+    static Vector add(Vector a, Vector b) { return _mm256_add_ps(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm256_sub_ps(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm256_mul_ps(a, b); }
+    static Vector div(Vector a, Vector b) { return _mm256_div_ps(a, b); }
+    static float dot(Vector a, Vector b) { return _mm256_cvtss_f32(_mm256_dp_ps(a, b, 0x71)); }
+};
+
+// 64 bytes in 2D, 96 in 3D
+template<int Dim>
+struct BasicParticle {
+    using Simd = ParticleSimd<Dim>;
+    
+    typename Simd::Vector position;  // (x,y[,z],_)
+    typename Simd::Vector velocity;  // (vx,vy[,vz],_)
+    float mass = 0.0f;
+    float charge = 0.0f;
+    float radius = 0.0f;
+    
+    // Sleep state, maintained by Simulation::updateSleepState
+    float restAnchor[Dim] = {};    // position at the start of the frame
+    uint32_t islandId = 0;         // island the particle fell asleep with
+    uint16_t restFrames = 0;       // consecutive frames spent resting
+    bool asleep = false;
+    bool alive = true;             // false for free slots in the pool
     
     void updatePosition(float dt) {
-        position = _mm256_add_ps(position,
-            _mm256_mul_ps(velocity, _mm256_set1_ps(dt)));
+        position = Simd::add(position, Simd::mul(velocity, Simd::splat(dt)));
     }
 };
 
+using Particle = BasicParticle<2>;
+using Particle3D = BasicParticle<3>;
+
 template<typename T>
 struct AlignedAllocator {
     using value_type = T;
@@ -36,13 +89,21 @@ struct AlignedAllocator {
 
     pointer allocate(size_type n) {
         if (n > std::size_t(-1) / sizeof(T)) throw std::bad_alloc();
+        // Particle-sized arrays go to huge pages
+        if (HugePageArena::isLarge(n * sizeof(T))) {
+            return static_cast<pointer>(HugePageArena::allocate(n * sizeof(T)));
+        }
         if (auto ptr = static_cast<pointer>(_mm_malloc(n * sizeof(T), 32))) 
             return ptr;
         throw std::bad_alloc();
     }
 
-    void deallocate(pointer p, size_type) noexcept {
-        _mm_free(p);
+    void deallocate(pointer p, size_type n) noexcept {
+        if (HugePageArena::isLarge(n * sizeof(T))) {
+            HugePageArena::deallocate(p, n * sizeof(T));
+        } else {
+            _mm_free(p);
+        }
     }
 };
 
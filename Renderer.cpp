@@ -97,7 +97,8 @@ void Renderer::initializeGL() {
     }
 }
 
-void Renderer::render(const std::vector<Particle, AlignedAllocator<Particle>>& particles) {
+template<int Dim>
+void Renderer::render(const std::vector<BasicParticle<Dim>, AlignedAllocator<BasicParticle<Dim>>>& particles) {
     try {
         glClear(GL_COLOR_BUFFER_BIT);
         glLoadIdentity();
@@ -106,6 +107,7 @@ void Renderer::render(const std::vector<Particle, AlignedAllocator<Particle>>& p
         glBegin(GL_POINTS);
         
         for (const auto& particle : particles) {
+            if (!particle.alive) continue;  // Free pool slot
             const float* pos = (float*)&particle.position;
             
             // Simple white color for visibility
@@ -127,6 +129,9 @@ void Renderer::render(const std::vector<Particle, AlignedAllocator<Particle>>& p
     }
 }
 
+template void Renderer::render<2>(const std::vector<Particle, AlignedAllocator<Particle>>&);
+template void Renderer::render<3>(const std::vector<Particle3D, AlignedAllocator<Particle3D>>&);
+
 bool Renderer::shouldClose() const {
     return glfwWindowShouldClose(window);
 }
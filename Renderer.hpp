@@ -8,7 +8,9 @@ public:
     Renderer(int width = 1024, int height = 768);
     ~Renderer();
     
-    void render(const std::vector<Particle, AlignedAllocator<Particle>>& particles);
+    // Draws the XY projection; instantiated for 2D and 3D particles
+    template<int Dim>
+    void render(const std::vector<BasicParticle<Dim>, AlignedAllocator<BasicParticle<Dim>>>& particles);
     bool shouldClose() const;
     bool isKeyPressed(char key) const;
     
@@ -5,37 +5,83 @@
 #include <random>
 #include <immintrin.h>
 #include <algorithm>
+#include <stdexcept>
+#include <iterator>
 
-Simulation::Simulation(size_t numParticles, float gravityValue, 
-                      float initialSpeed, float airFriction) 
+template<int Dim>
+BasicSimulation<Dim>::BasicSimulation(size_t numParticles, float gravityValue, 
+                      float initialSpeed, float airFriction,
+                      float minRadius, float maxRadius,
+                      std::unique_ptr<Transport> particleTransport, uint32_t seed) 
     : gravity(gravityValue), 
       initialSpeed(initialSpeed),
       dragCoefficient(airFriction),
-      particleHash(numParticles),
+      maxRadius(std::max(minRadius, maxRadius)),
+      haloWidth(2.0f * this->maxRadius),
+      particleHash(numParticles, 2.0f * std::min(minRadius, maxRadius)),
+      transport(std::move(particleTransport)),
+      slabLeft(SCREEN_LEFT),
+      slabRight(SCREEN_RIGHT),
       numParticles(numParticles),
       windowWidth(800),    // Add default window width
       windowHeight(600)    // Add default window height
 { 
-    std::cout << "Initializing simulation with parameters:" << std::endl
-              << "Particles: " << numParticles << std::endl
-              << "Gravity: " << gravityValue << std::endl
-              << "Speed: " << initialSpeed << std::endl
-              << "Friction: " << airFriction << std::endl;
-              
+    // The library stays silent on stdout; hosts report setup themselves
     try {
         meshOctree = std::make_unique<Octree>("bunny.obj");
     } catch (const std::exception& e) {
-        std::cout << "Warning: Could not load mesh, continuing without it\n";
         // Continue without mesh - it's optional
     }
     
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> posX(-8.0f, 8.0f);
+    const float spawnMin = -8.0f;
+    const float spawnMax = 8.0f;
+    float spawnLeft = spawnMin;
+    float spawnRight = spawnMax;
+    
+    if (transport) {
+        int rank = transport->rank();
+        int ranks = transport->size();
+        float slabWidth = (SCREEN_RIGHT - SCREEN_LEFT) / ranks;
+        
+        // Ghosts only come from the adjacent ranks and particles migrate at
+        // most one slab per step, so a slab must be at least a halo wide
+        if (slabWidth < haloWidth) {
+            throw std::invalid_argument("Too many processes: slabs would be narrower than "
+                                        "the largest particle diameter");
+        }
+        slabLeft = SCREEN_LEFT + slabWidth * rank;
+        slabRight = (rank == ranks - 1) ? SCREEN_RIGHT : slabLeft + slabWidth;
+        
+        // Give each rank the share of particles that would have spawned in its slab
+        auto spawnedBefore = [&](float x) {
+            float covered = std::clamp(x, spawnMin, spawnMax) - spawnMin;
+            return static_cast<size_t>(numParticles * (covered / (spawnMax - spawnMin)));
+        };
+        size_t first = spawnedBefore(slabLeft);
+        size_t last = (rank == ranks - 1) ? numParticles : spawnedBefore(slabRight);
+        numParticles = last - first;
+        this->numParticles = static_cast<int>(numParticles);
+        
+        spawnLeft = std::clamp(slabLeft, spawnMin, spawnMax);
+        spawnRight = std::clamp(slabRight, spawnMin, spawnMax);
+    }
+    
+    // Separate streams per rank and for setup versus emitters
+    uint32_t baseSeed = seed == RANDOM_SEED ? std::random_device{}() : seed;
+    uint32_t rankSeed = transport ? static_cast<uint32_t>(transport->rank()) : 0;
+    std::seed_seq setupSeed{baseSeed, rankSeed, 0u};
+    std::seed_seq emitterSeed{baseSeed, rankSeed, 1u};
+    std::mt19937 gen(setupSeed);
+    spawnRng.seed(emitterSeed);
+    std::uniform_real_distribution<float> posX(spawnLeft, spawnRight);
     std::uniform_real_distribution<float> posY(-8.0f, 8.0f);
+    std::uniform_real_distribution<float> posZ(SCREEN_NEAR, SCREEN_FAR);
     std::uniform_real_distribution<float> velDist(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> radiusDist(std::min(minRadius, maxRadius), this->maxRadius);
     
-    particles.reserve(numParticles);
+    // Pool first, so the particle array is pre-faulted by its workers
+    setThreadCount(THREAD_COUNT);
+    reserveParticles(numParticles);
     for (size_t i = 0; i < numParticles; ++i) {
         Particle p;
         float* position = (float*)&p.position;
@@ -43,52 +89,316 @@ Simulation::Simulation(size_t numParticles, float gravityValue,
         
         position[0] = posX(gen);
         position[1] = posY(gen);
-        position[2] = 0.0f;
+        position[2] = Dim == 3 ? posZ(gen) : 0.0f;
         position[3] = 0.0f;
         
         velocity[0] = velDist(gen) * initialSpeed;
         velocity[1] = velDist(gen) * initialSpeed;
-        velocity[2] = 0.0f;
+        velocity[2] = Dim == 3 ? velDist(gen) * initialSpeed : 0.0f;
         velocity[3] = 0.0f;
         
-        p.mass = 1.0f;
+        p.radius = radiusDist(gen);
+        p.mass = massFor(p.radius);
         particles.push_back(p);
-        
-        if (i < 5) {  // Only print first 5 particles
-            std::cout << "Particle " << i << " created at (" 
-                      << position[0] << ", " << position[1] << ")" << std::endl;
+    }
+    
+    liveCount = particles.size();
+    activeEnd = particles.size();
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::setThreadCount(size_t count) {
+    workers = std::make_unique<ThreadPool>(std::max<size_t>(1, count), pinThreads);
+    workerContacts.resize(workers->size());
+    workerWoken.resize(workers->size());
+    workerKilled.resize(workers->size());
+    
+    // Re-fault the particle array under the new split
+    if (particles.capacity() > 0) {
+        reserveParticles(particles.capacity());
+    }
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::setThreadPinning(bool enabled) {
+    if (enabled == pinThreads) return;
+    pinThreads = enabled;
+    setThreadCount(workers->size());
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::reserveParticles(size_t capacity) {
+    std::vector<Particle, AlignedAllocator<Particle>> placed;
+    placed.reserve(capacity);
+    // Only large arrays come from unfaulted huge pages
+    if (HugePageArena::isLarge(capacity * sizeof(Particle))) {
+        workers->firstTouch(placed.data(), capacity, sizeof(Particle));
+    }
+    placed.assign(particles.begin(), particles.end());
+    particles.swap(placed);
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::setParticleCapacity(size_t capacity) {
+    if (storageMode != StorageMode::Full) {
+        throw std::logic_error("Particle pool needs fp32 storage");
+    }
+    if (capacity <= particles.size()) return;
+    
+    // Grow once up front; new slots start dead and zeroed
+    size_t oldSize = particles.size();
+    Particle freeSlot;
+    freeSlot.position = Simd::zero();
+    freeSlot.velocity = Simd::zero();
+    freeSlot.alive = false;
+    reserveParticles(capacity);
+    particles.resize(capacity, freeSlot);
+    
+    freeSlots.reserve(capacity);
+    for (size_t i = oldSize; i < capacity; ++i) {
+        freeSlots.push_back(static_cast<uint32_t>(i));
+    }
+    std::make_heap(freeSlots.begin(), freeSlots.end(), std::greater<uint32_t>());
+}
+
+template<int Dim>
+size_t BasicSimulation<Dim>::addEmitter(const Emitter& emitter) {
+    if (storageMode != StorageMode::Full) {
+        throw std::logic_error("Emitters need fp32 storage");
+    }
+    if (emitter.rate < 0.0f || emitter.radius <= 0.0f || emitter.spread < 0.0f) {
+        throw std::invalid_argument("Emitter needs a non-negative rate and spread and a positive radius");
+    }
+    if (emitter.radius > maxRadius) {
+        // Halo width and grid levels are sized for the largest radius
+        throw std::invalid_argument("Emitter radius exceeds the simulation's maximum radius");
+    }
+    emitters.push_back(emitter);
+    emitterCarry.push_back(0.0f);
+    return emitters.size() - 1;
+}
+
+template<int Dim>
+size_t BasicSimulation<Dim>::addSink(const Sink& sink) {
+    if (storageMode != StorageMode::Full) {
+        throw std::logic_error("Sinks need fp32 storage");
+    }
+    if (!(sink.left < sink.right) || !(sink.bottom < sink.top)) {
+        throw std::invalid_argument("Sink box is empty");
+    }
+    sinks.push_back(sink);
+    return sinks.size() - 1;
+}
+
+template<int Dim>
+bool BasicSimulation<Dim>::spawnParticle(const Particle& particle, bool growIfFull) {
+    size_t slot;
+    if (!freeSlots.empty()) {
+        std::pop_heap(freeSlots.begin(), freeSlots.end(), std::greater<uint32_t>());
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        particles[slot] = particle;
+    } else if (growIfFull) {
+        slot = particles.size();
+        particles.push_back(particle);
+    } else {
+        return false;
+    }
+    particles[slot].alive = true;
+    ++liveCount;
+    activeEnd = std::max(activeEnd, slot + 1);
+    return true;
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::killParticle(size_t index) {
+    Particle& p = particles[index];
+    p.alive = false;
+    p.asleep = false;
+    p.restFrames = 0;
+    freeSlots.push_back(static_cast<uint32_t>(index));
+    std::push_heap(freeSlots.begin(), freeSlots.end(), std::greater<uint32_t>());
+    --liveCount;
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::applySinks() {
+    if (sinks.empty()) return;
+    
+    workers->run([&](size_t worker) {
+        size_t begin, end;
+        ThreadPool::chunk(activeEnd, worker, workers->size(), begin, end);
+        auto& killed = workerKilled[worker];
+        killed.clear();
+        for (size_t i = begin; i < end; ++i) {
+            const Particle& p = particles[i];
+            if (!p.alive) continue;
+            const float* pos = (const float*)&p.position;
+            for (const Sink& sink : sinks) {
+                if (pos[0] >= sink.left && pos[0] < sink.right &&
+                    pos[1] >= sink.bottom && pos[1] < sink.top) {
+                    killed.push_back(static_cast<uint32_t>(i));
+                    break;
+                }
+            }
+        }
+    });
+    
+    // Freeing in worker order keeps slot reuse independent of thread count.
+    // A removed sleeper takes its island with it.
+    wokenIslands.clear();
+    for (const auto& killed : workerKilled) {
+        for (uint32_t i : killed) {
+            if (particles[i].asleep) wokenIslands.push_back(particles[i].islandId);
+            killParticle(i);
         }
     }
     
-    for (auto& particle : particles) {
-        float* pos = (float*)&particle.position;
-        std::cout << "Particle pos: (" << pos[0] << ", " << pos[1] << ")" << std::endl;
+    // Sleepers resting on a removed awake particle touched it last frame
+    for (const Contact& contact : contacts) {
+        if (contact.first >= particles.size() || contact.second >= particles.size()) continue;
+        const Particle& first = particles[contact.first];
+        const Particle& second = particles[contact.second];
+        if (!first.alive && second.alive && second.asleep) wokenIslands.push_back(second.islandId);
+        if (!second.alive && first.alive && first.asleep) wokenIslands.push_back(first.islandId);
+    }
+    wakeIslands();
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::runEmitters(float deltaTime) {
+    for (size_t e = 0; e < emitters.size(); ++e) {
+        const Emitter& emitter = emitters[e];
+        
+        // Each emitter belongs to the rank whose slab holds it
+        if (transport && (emitter.x < slabLeft || emitter.x >= slabRight)) continue;
+        
+        emitterCarry[e] += emitter.rate * deltaTime;
+        int due = static_cast<int>(emitterCarry[e]);
+        emitterCarry[e] -= due;
+        
+        std::uniform_real_distribution<float> jitter(-emitter.radius, emitter.radius);
+        std::uniform_real_distribution<float> spread(-emitter.spread, emitter.spread);
+        for (int n = 0; n < due; ++n) {
+            // Emitters sit in the z = 0 plane; 3D particles leave it with some jitter
+            float x = emitter.x + jitter(spawnRng);
+            float y = emitter.y + jitter(spawnRng);
+            float vx = emitter.velocityX + spread(spawnRng);
+            float vy = emitter.velocityY + spread(spawnRng);
+            float z = Dim == 3 ? jitter(spawnRng) : 0.0f;
+            float vz = Dim == 3 ? spread(spawnRng) : 0.0f;
+            
+            Particle p;
+            p.position = Simd::make(x, y, z);
+            p.velocity = Simd::make(vx, vy, vz);
+            p.radius = emitter.radius;
+            p.mass = massFor(emitter.radius);
+            
+            // A full pool drops the rest of this frame's particles
+            if (!spawnParticle(p)) {
+                emitterCarry[e] = 0.0f;
+                break;
+            }
+        }
+    }
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::compactParticles() {
+    // Stable, so live particles keep their relative order
+    size_t kept = 0;
+    for (size_t i = 0; i < activeEnd; ++i) {
+        if (particles[i].alive) {
+            if (kept != i) {
+                particles[kept] = particles[i];
+                particles[i].alive = false;
+            }
+            ++kept;
+        }
     }
     
-    std::cout << "Initialized " << numParticles << " particles\n";
+    // Ascending order is already a valid min-heap
+    freeSlots.clear();
+    for (size_t i = kept; i < particles.size(); ++i) {
+        freeSlots.push_back(static_cast<uint32_t>(i));
+    }
+    activeEnd = kept;
+    framesSinceCompaction = 0;
 }
 
-void Simulation::update(float deltaTime, float speedMultiplier) {
+template<int Dim>
+void BasicSimulation<Dim>::update(float deltaTime, float speedMultiplier) {
     try {
         deltaTime *= speedMultiplier;
         
-        // Single-threaded update for stability
-        updateParticlesBatch(0, particles.size(), deltaTime);
+        if (storageMode == StorageMode::Compressed) {
+            updateCompressed(deltaTime);
+            releaseFrameBuffers();
+            return;
+        }
+        
+        // Retire and spawn before integrating so new particles move this frame
+        applySinks();
+        runEmitters(deltaTime);
+        if (++framesSinceCompaction >= COMPACTION_INTERVAL &&
+            activeEnd - liveCount > COMPACTION_THRESHOLD * activeEnd) {
+            compactParticles();
+        }
+        
+        // Each worker integrates the chunk it first touched
+        workers->run([&](size_t worker) {
+            size_t begin, end;
+            ThreadPool::chunk(activeEnd, worker, workers->size(), begin, end);
+            updateParticlesBatch(begin, end, deltaTime);
+        });
+        
+        // Hand off particles that left our slab, then borrow neighbors'
+        // edge particles as ghosts so collisions across the seam are seen
+        size_t ownedCount = particles.size();
+        if (transport) {
+            migrateParticles();
+            ownedCount = particles.size();
+            exchangeHalo();
+        }
         
         // Update spatial hash after position updates
         particleHash.update(particles);
         
-        // Simple collision handling
+        detectContacts(activeEnd, ownedCount);
+        
+        islandParent.resize(particles.size());
         for (size_t i = 0; i < particles.size(); ++i) {
-            handleParticleCollisions(i, i + 1);
-            handleScreenBoundaries(particles[i]);
+            islandParent[i] = static_cast<uint32_t>(i);
+        }
+        for (const Contact& contact : contacts) {
+            mergeIslands(contact.first, contact.second);
         }
         
-        // Debug output
-        if (!particles.empty()) {
-            float* pos = (float*)&particles[0].position;
-            std::cout << "\rFirst particle at: (" << pos[0] << ", " << pos[1] << ")" << std::flush;
+        if (solverMode == SolverMode::Serial) {
+            solveContactsSerial();
+        } else {
+            colorContacts();
+            solveContacts();
         }
+        
+        workers->run([&](size_t worker) {
+            size_t begin, end;
+            ThreadPool::chunk(activeEnd, worker, workers->size(), begin, end);
+            for (size_t i = begin; i < end; ++i) {
+                if (particles[i].alive && !particles[i].asleep) handleScreenBoundaries(particles[i]);
+            }
+        });
+        
+        wakeIslands();
+        updateSleepState(ownedCount, deltaTime);
+        
+        // Ghosts are owned by a neighbor, which resolves its own side
+        particles.resize(ownedCount);
+        
+        releaseFrameBuffers();
+    }
+    catch (const TransportClosed&) {
+        throw;  // Normal shutdown of a distributed run
     }
     catch (const std::exception& e) {
         std::cerr << "Error in simulation update: " << e.what() << std::endl;
@@ -96,25 +406,162 @@ void Simulation::update(float deltaTime, float speedMultiplier) {
     }
 }
 
-void Simulation::updateParticlesBatch(size_t start, size_t end, float deltaTime) {
-    try {
-        __m256 dt = _mm256_set1_ps(deltaTime);
-        __m256 grav = _mm256_set1_ps(gravity);
+template<int Dim>
+const std::vector<typename BasicSimulation<Dim>::Particle, AlignedAllocator<typename BasicSimulation<Dim>::Particle>>&
+BasicSimulation<Dim>::getParticles() const {
+    if constexpr (Dim == 2) {
+        if (storageMode == StorageMode::Compressed) {
+            compressedParticles.decodeAll(decodedParticles);
+            return decodedParticles;
+        }
+    }
+    return particles;
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::setStorageMode(StorageMode mode) {
+    if (mode == storageMode) return;
+    
+    if constexpr (Dim != 2) {
+        throw std::logic_error("Compressed storage only supports 2D simulations");
+    } else if (mode == StorageMode::Compressed) {
+        if (transport) {
+            throw std::logic_error("Compressed storage is not supported with domain decomposition");
+        }
+        if (!emitters.empty() || !sinks.empty()) {
+            throw std::logic_error("Compressed storage does not support emitters or sinks");
+        }
+        
+        // Compressed storage has no pool, so drop the free slots
+        compactParticles();
+        particles.resize(liveCount);
+        freeSlots.clear();
+        compressedParticles.assign(particles, particleHash.cellSize(0));
+        
+        compressionError = compressedParticles.compare(particles);
         
+        // Release the fp32 copy; that memory is the point of compressing
+        if (trackCompressionDrift) {
+            driftReference.swap(particles);
+        }
+        std::vector<Particle, AlignedAllocator<Particle>>().swap(particles);
+    } else {
+        compressedParticles.decodeAll(particles);
+        liveCount = particles.size();
+        activeEnd = particles.size();
+        compressedParticles = CompressedParticles();
+        std::vector<Particle, AlignedAllocator<Particle>>().swap(decodedParticles);
+        std::vector<Particle, AlignedAllocator<Particle>>().swap(driftReference);
+    }
+    storageMode = mode;
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::setCompressionDriftTracking(bool enabled) {
+    if (enabled == trackCompressionDrift) return;
+    
+    trackCompressionDrift = enabled;
+    if (!enabled) {
+        std::vector<Particle, AlignedAllocator<Particle>>().swap(driftReference);
+    } else if constexpr (Dim == 2) {
+        if (storageMode == StorageMode::Compressed) {
+            compressedParticles.decodeAll(driftReference);  // Drift from here on
+        }
+    }
+}
+
+template<int Dim>
+CompressedParticles::Error BasicSimulation<Dim>::getCompressionDrift() const {
+    if constexpr (Dim == 2) {
+        if (trackCompressionDrift && storageMode == StorageMode::Compressed) {
+            return compressedParticles.compare(driftReference);
+        }
+    }
+    return CompressedParticles::Error();
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::updateCompressed(float deltaTime) {
+    if constexpr (Dim == 2) {
+        compressedParticles.integrate(deltaTime, gravity, dragCoefficient);
+        for (Particle& p : driftReference) {
+            integrateParticle(p, deltaTime);
+        }
+        
+        particleHash.update(compressedParticles);
+        handleCompressedCollisions();
+        
+        compressedParticles.applyBounds(SCREEN_LEFT, SCREEN_RIGHT, SCREEN_BOTTOM, SCREEN_TOP,
+                                        BOUNCE_FACTOR, 0.98f);
+        for (Particle& p : driftReference) {
+            handleScreenBoundaries(p);
+        }
+    }
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::handleCompressedCollisions() {
+    // Compressed storage only holds 2D particles
+    if constexpr (Dim == 2) {
+        // Each pair is decompressed into registers, resolved with the fp32
+        // solver and only the new velocities are packed back
+        Particle p1;
+        Particle p2;
+        for (size_t i = 0; i < compressedParticles.size(); ++i) {
+            compressedParticles.decode(i, p1);
+            int level = particleHash.getLevel(i);
+            auto nearbyIndices = particleHash.getCollisionCandidates(i, p1);
+            
+            bool touched = false;
+            for (size_t j : nearbyIndices) {
+                // Avoid double-checking pairs on our own level
+                if (i == j || (j < i && particleHash.getLevel(j) == level)) continue;
+                
+                compressedParticles.decode(j, p2);
+                if (checkParticleCollision(p1, p2)) {
+                    resolveParticleCollision(p1, p2, wokenIslands);
+                    compressedParticles.storeVelocity(j, p2.velocity);
+                    touched = true;
+                }
+                
+                // The drift reference sees the same pairs in the same order
+                if (trackCompressionDrift) {
+                    Particle& r1 = driftReference[compressedParticles.idOf(i)];
+                    Particle& r2 = driftReference[compressedParticles.idOf(j)];
+                    if (checkParticleCollision(r1, r2)) {
+                        resolveParticleCollision(r1, r2, wokenIslands);
+                    }
+                }
+            }
+            if (touched) {
+                compressedParticles.storeVelocity(i, p1.velocity);
+            }
+        }
+    }
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::releaseFrameBuffers() {
+    // Everything transient this frame came from the frame arenas
+    particleHash.releaseFrameStorage();
+    compressedParticles.releaseFrameStorage();
+    FrameArena::local().reset();
+    workers->run([](size_t) { FrameArena::local().reset(); });
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::updateParticlesBatch(size_t start, size_t end, float deltaTime) {
+    try {
         for (size_t i = start; i < end && i < particles.size(); ++i) {
             Particle& p = particles[i];
+            if (!p.alive || p.asleep) continue;
             
-            // Update velocity with gravity
-            p.velocity = _mm256_add_ps(p.velocity, 
-                _mm256_mul_ps(_mm256_set_ps(0,0,1,0, 0,0,1,0), grav));
-            
-            // Update position
-            p.position = _mm256_add_ps(p.position, 
-                _mm256_mul_ps(p.velocity, dt));
+            const float* pos = (const float*)&p.position;
+            for (int axis = 0; axis < Dim; ++axis) {
+                p.restAnchor[axis] = pos[axis];
+            }
             
-            // Apply air resistance
-            p.velocity = _mm256_mul_ps(p.velocity, 
-                _mm256_set1_ps(1.0f - dragCoefficient * deltaTime));
+            integrateParticle(p, deltaTime);
         }
     }
     catch (const std::exception& e) {
@@ -123,86 +570,190 @@ void Simulation::updateParticlesBatch(size_t start, size_t end, float deltaTime)
     }
 }
 
-__m256 Simulation::calculateAirResistance(const __m256& velocity, float deltaTime) const {
+template<int Dim>
+void BasicSimulation<Dim>::integrateParticle(Particle& p, float deltaTime) const {
+    // Update velocity with gravity
+    p.velocity = Simd::add(p.velocity, 
+        Simd::mul(Simd::make(0, 1, 0), Simd::splat(gravity)));
+    
+    // Update position
+    p.position = Simd::add(p.position, 
+        Simd::mul(p.velocity, Simd::splat(deltaTime)));
+    
+    // Apply air resistance
+    p.velocity = Simd::mul(p.velocity, 
+        Simd::splat(1.0f - dragCoefficient * deltaTime));
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::exchangeWithNeighbor(int peer,
+                                      const std::vector<Particle, AlignedAllocator<Particle>>& outgoing,
+                                      std::vector<Particle, AlignedAllocator<Particle>>& received) {
+    // Lower rank sends first so the chain of blocking exchanges can't deadlock
+    if (transport->rank() < peer) {
+        transport->send(peer, outgoing);
+        transport->receive(peer, received);
+    } else {
+        transport->receive(peer, received);
+        transport->send(peer, outgoing);
+    }
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::migrateParticles() {
+    int rank = transport->rank();
+    int lastRank = transport->size() - 1;
+    
+    outgoingLeft.clear();
+    outgoingRight.clear();
+    for (size_t i = 0; i < activeEnd; ++i) {
+        if (!particles[i].alive) continue;
+        float x = ((float*)&particles[i].position)[0];
+        if (rank > 0 && x < slabLeft) {
+            outgoingLeft.push_back(particles[i]);
+            killParticle(i);
+        } else if (rank < lastRank && x >= slabRight) {
+            outgoingRight.push_back(particles[i]);
+            killParticle(i);
+        }
+    }
+    
+    // Arrivals reuse the slots departures just freed; the pool only grows
+    // when more particles crowd into this slab than it has room for
+    if (rank > 0) {
+        exchangeWithNeighbor(rank - 1, outgoingLeft, incoming);
+        for (const auto& particle : incoming) {
+            spawnParticle(particle, true);
+        }
+    }
+    if (rank < lastRank) {
+        exchangeWithNeighbor(rank + 1, outgoingRight, incoming);
+        for (const auto& particle : incoming) {
+            spawnParticle(particle, true);
+        }
+    }
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::exchangeHalo() {
+    int rank = transport->rank();
+    int lastRank = transport->size() - 1;
+    
+    outgoingLeft.clear();
+    outgoingRight.clear();
+    for (const auto& particle : particles) {
+        if (!particle.alive) continue;
+        float x = ((const float*)&particle.position)[0];
+        if (rank > 0 && x < slabLeft + haloWidth) {
+            outgoingLeft.push_back(particle);
+        }
+        if (rank < lastRank && x >= slabRight - haloWidth) {
+            outgoingRight.push_back(particle);
+        }
+    }
+    
+    if (rank > 0) {
+        exchangeWithNeighbor(rank - 1, outgoingLeft, incoming);
+        particles.insert(particles.end(), incoming.begin(), incoming.end());
+    }
+    if (rank < lastRank) {
+        exchangeWithNeighbor(rank + 1, outgoingRight, incoming);
+        particles.insert(particles.end(), incoming.begin(), incoming.end());
+    }
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::gatherParticles(std::vector<Particle, AlignedAllocator<Particle>>& out) {
+    out.clear();
+    std::copy_if(particles.begin(), particles.end(), std::back_inserter(out),
+                 [](const Particle& p) { return p.alive; });
+    if (!transport) return;
+    
+    // Everything flows leftward: each rank appends what it got from the right
+    int rank = transport->rank();
+    if (rank < transport->size() - 1) {
+        transport->receive(rank + 1, incoming);
+        out.insert(out.end(), incoming.begin(), incoming.end());
+    }
+    if (rank > 0) {
+        transport->send(rank - 1, out);
+    }
+}
+
+template<int Dim>
+typename BasicSimulation<Dim>::Vector BasicSimulation<Dim>::calculateAirResistance(const Vector& velocity, float deltaTime) const {
     // Calculate velocity magnitude squared
-    __m256 velSq = _mm256_dp_ps(velocity, velocity, 0x71);
+    float velSq = Simd::dot(velocity, velocity);
     
     // Calculate drag force magnitude: F = 0.5 * rho * v^2 * Cd * A
     // where rho is air density, v is velocity, Cd is drag coefficient, A is cross-sectional area
     float area = M_PI * PARTICLE_RADIUS * PARTICLE_RADIUS;
     float dragConstant = 0.5f * AIR_DENSITY * dragCoefficient * area;
-    __m256 dragForce = _mm256_mul_ps(velSq, _mm256_set1_ps(dragConstant));
+    Vector dragForce = Simd::splat(velSq * dragConstant);
     
     // Convert force to velocity change
-    __m256 velocityChange = _mm256_mul_ps(
-        _mm256_mul_ps(velocity, dragForce),
-        _mm256_set1_ps(-deltaTime)
+    Vector velocityChange = Simd::mul(
+        Simd::mul(velocity, dragForce),
+        Simd::splat(-deltaTime)
     );
     
     return velocityChange;
 }
 
-void Simulation::calculateForcesSIMD() {
+template<int Dim>
+void BasicSimulation<Dim>::calculateForcesSIMD() {
     const float coulombConstant = 8.99e9f;
-    __m256 k = _mm256_set1_ps(coulombConstant);
     
     for (size_t i = 0; i < particles.size(); ++i) {
         Particle& p1 = particles[i];
         auto nearbyIndices = particleHash.getNearbyParticles(p1, 5.0f);
         
-        __m256 force_sum = _mm256_setzero_ps();
-        __m256 p1_pos = p1.position;
-        __m256 p1_charge = _mm256_set1_ps(p1.charge);
+        Vector force_sum = Simd::zero();
+        Vector p1_pos = p1.position;
         
         for (size_t j : nearbyIndices) {
             if (i == j) continue;
             
             Particle& p2 = particles[j];
-            __m256 p2_pos = p2.position;
-            __m256 p2_charge = _mm256_set1_ps(p2.charge);
+            Vector p2_pos = p2.position;
             
             // Calculate distance vector
-            __m256 dist_vec = _mm256_sub_ps(p2_pos, p1_pos);
-            
-            // Calculate distance squared
-            __m256 dist_sq = _mm256_dp_ps(dist_vec, dist_vec, 0x71);
+            Vector dist_vec = Simd::sub(p2_pos, p1_pos);
             
-            // Prevent division by zero
-            dist_sq = _mm256_add_ps(dist_sq, _mm256_set1_ps(1e-6f));
+            // Calculate distance squared, preventing division by zero
+            float dist_sq = Simd::dot(dist_vec, dist_vec) + 1e-6f;
             
             // Calculate Coulomb force
-            __m256 force_mag = _mm256_div_ps(
-                _mm256_mul_ps(_mm256_mul_ps(k, p1_charge), p2_charge),
-                _mm256_mul_ps(dist_sq, _mm256_sqrt_ps(dist_sq))
-            );
+            float force_mag = coulombConstant * p1.charge * p2.charge /
+                              (dist_sq * std::sqrt(dist_sq));
             
             // Add to force sum
-            force_sum = _mm256_add_ps(force_sum,
-                _mm256_mul_ps(dist_vec, _mm256_broadcast_ss((float*)&force_mag))
-            );
+            force_sum = Simd::add(force_sum, Simd::mul(dist_vec, Simd::splat(force_mag)));
         }
         
         // Update velocity based on force
-        p1.velocity = _mm256_add_ps(p1.velocity, force_sum);
+        p1.velocity = Simd::add(p1.velocity, force_sum);
     }
 }
 
-void Simulation::handleCollisions() {
+template<int Dim>
+void BasicSimulation<Dim>::handleCollisions() {
     const float restitution = 0.8f;
-    __m256 rest = _mm256_set1_ps(restitution);
+    Vector rest = Simd::splat(restitution);
     
     for (auto& particle : particles) {
-        if (meshOctree->checkCollision(particle.position, 0.1f)) {
+        if (meshOctree->checkCollision((const float*)&particle.position, 0.1f)) {
             // Simple bounce - invert velocity with restitution
-            particle.velocity = _mm256_mul_ps(
-                _mm256_mul_ps(particle.velocity, _mm256_set1_ps(-1.0f)),
+            particle.velocity = Simd::mul(
+                Simd::mul(particle.velocity, Simd::splat(-1.0f)),
                 rest
             );
         }
     }
 }
 
-void Simulation::handleScreenBoundaries(Particle& p) {
+template<int Dim>
+void BasicSimulation<Dim>::handleScreenBoundaries(Particle& p) {
     float* pos = (float*)&p.position;
     float* vel = (float*)&p.velocity;
     
@@ -224,65 +775,354 @@ void Simulation::handleScreenBoundaries(Particle& p) {
         vel[1] = -vel[1] * BOUNCE_FACTOR;
     }
     
+    // Z boundaries (near and far) only exist in 3D
+    bool onDepthWall = false;
+    if constexpr (Dim == 3) {
+        if (pos[2] < SCREEN_NEAR) {
+            pos[2] = SCREEN_NEAR;
+            vel[2] = -vel[2] * BOUNCE_FACTOR;
+        } else if (pos[2] > SCREEN_FAR) {
+            pos[2] = SCREEN_FAR;
+            vel[2] = -vel[2] * BOUNCE_FACTOR;
+        }
+        onDepthWall = pos[2] == SCREEN_NEAR || pos[2] == SCREEN_FAR;
+    }
+    
     // Apply additional drag when hitting boundaries to simulate friction
     if (pos[1] == SCREEN_BOTTOM || pos[1] == SCREEN_TOP || 
-        pos[0] == SCREEN_LEFT || pos[0] == SCREEN_RIGHT) {
+        pos[0] == SCREEN_LEFT || pos[0] == SCREEN_RIGHT || onDepthWall) {
         vel[0] *= 0.98f; // Horizontal friction
         vel[2] *= 0.98f; // Z-axis friction
     }
 }
 
-void Simulation::handleParticleCollisions(size_t startIdx, size_t endIdx) {
+template<int Dim>
+void BasicSimulation<Dim>::findContacts(size_t startIdx, size_t endIdx, std::vector<Contact>& out) {
     for (size_t i = startIdx; i < endIdx; ++i) {
         Particle& p1 = particles[i];
-        auto nearbyIndices = particleHash.getNearbyParticles(p1, PARTICLE_RADIUS * 2.0f);
+        if (!p1.alive) continue;
+        int level = particleHash.getLevel(i);
+        
+        // Sleeping particles only take part when an awake neighbor runs into
+        // them. A larger neighbor never sees a smaller one, so sleepers still
+        // look up while coarser levels exist.
+        if (p1.asleep && !particleHash.hasCoarserLevels(level)) continue;
+        
+        auto nearbyIndices = particleHash.getCollisionCandidates(i, p1);
         
         for (size_t j : nearbyIndices) {
-            if (i >= j) continue; // Avoid double-checking pairs
+            if (i == j) continue;
+            
+            // Coarser candidates only ever see this pair from our side. On our
+            // own level avoid double-checking pairs, except with sleepers,
+            // which never start a check of their own.
+            const Particle& p2 = particles[j];
+            bool sameLevel = particleHash.getLevel(j) == level;
+            if (p1.asleep) {
+                if (sameLevel || p2.asleep) continue;
+            } else if (sameLevel && j < i && !p2.asleep) {
+                continue;
+            }
             
-            Particle& p2 = particles[j];
             if (checkParticleCollision(p1, p2)) {
-                resolveParticleCollision(p1, p2);
+                out.push_back({static_cast<uint32_t>(i), static_cast<uint32_t>(j)});
+            }
+        }
+    }
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::findGhostContacts(size_t startIdx, size_t endIdx, size_t ownedCount,
+                                             std::vector<Contact>& out) {
+    // Owned particles never look down a level, so a ghost on a finer level
+    // than an owned particle has to start the check itself. Same-level
+    // ghosts are found from the owned side like any other pair.
+    for (size_t g = startIdx; g < endIdx; ++g) {
+        const Particle& ghost = particles[g];
+        int level = particleHash.getLevel(g);
+        if (!particleHash.hasCoarserLevels(level)) continue;
+        
+        auto nearbyIndices = particleHash.getCollisionCandidates(g, ghost);
+        for (size_t j : nearbyIndices) {
+            if (j >= ownedCount || particleHash.getLevel(j) == level) continue;
+            
+            const Particle& owned = particles[j];
+            if (ghost.asleep && owned.asleep) continue;
+            if (checkParticleCollision(ghost, owned)) {
+                out.push_back({static_cast<uint32_t>(g), static_cast<uint32_t>(j)});
+            }
+        }
+    }
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::detectContacts(size_t scanEnd, size_t ownedCount) {
+    // Read-only, so workers can scan their chunks concurrently
+    workers->run([&](size_t worker) {
+        size_t begin, end;
+        ThreadPool::chunk(scanEnd, worker, workers->size(), begin, end);
+        workerContacts[worker].clear();
+        findContacts(begin, end, workerContacts[worker]);
+    });
+    
+    // Concatenating in worker order gives the same list for any thread count
+    contacts.clear();
+    for (const auto& found : workerContacts) {
+        contacts.insert(contacts.end(), found.begin(), found.end());
+    }
+    
+    // Ghost-started contacts go after all owned ones to keep that order
+    size_t ghostCount = particles.size() - ownedCount;
+    if (ghostCount == 0) return;
+    workers->run([&](size_t worker) {
+        size_t begin, end;
+        ThreadPool::chunk(ghostCount, worker, workers->size(), begin, end);
+        workerContacts[worker].clear();
+        findGhostContacts(ownedCount + begin, ownedCount + end, ownedCount, workerContacts[worker]);
+    });
+    for (const auto& found : workerContacts) {
+        contacts.insert(contacts.end(), found.begin(), found.end());
+    }
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::colorContacts() {
+    // Greedy coloring: each contact takes the lowest color neither of its
+    // particles has used yet. Contacts that run out of colors go into one
+    // extra batch that is solved serially.
+    particleColors.assign(particles.size(), 0);
+    contactColors.resize(contacts.size());
+    colorOffsets.fill(0);
+    
+    for (size_t k = 0; k < contacts.size(); ++k) {
+        uint64_t& first = particleColors[contacts[k].first];
+        uint64_t& second = particleColors[contacts[k].second];
+        uint64_t freeColors = ~(first | second);
+        int color = MAX_COLORS;
+        if (freeColors != 0) {
+            color = __builtin_ctzll(freeColors);
+            first |= uint64_t(1) << color;
+            second |= uint64_t(1) << color;
+        }
+        contactColors[k] = static_cast<uint8_t>(color);
+        ++colorOffsets[color + 1];
+    }
+    
+    for (int color = 0; color <= MAX_COLORS; ++color) {
+        colorOffsets[color + 1] += colorOffsets[color];
+    }
+    
+    // Stable scatter keeps detection order inside each color
+    coloredContacts.resize(contacts.size());
+    std::array<uint32_t, MAX_COLORS + 1> cursor;
+    std::copy(colorOffsets.begin(), colorOffsets.begin() + MAX_COLORS + 1, cursor.begin());
+    for (size_t k = 0; k < contacts.size(); ++k) {
+        coloredContacts[cursor[contactColors[k]]++] = contacts[k];
+    }
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::solveContactsSerial() {
+    wokenIslands.clear();
+    for (int iteration = 0; iteration < solverIterations; ++iteration) {
+        for (const Contact& contact : contacts) {
+            resolveParticleCollision(particles[contact.first], particles[contact.second], wokenIslands);
+        }
+    }
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::solveContacts() {
+    for (auto& woken : workerWoken) {
+        woken.clear();
+    }
+    
+    for (int iteration = 0; iteration < solverIterations; ++iteration) {
+        for (int color = 0; color <= MAX_COLORS; ++color) {
+            size_t first = colorOffsets[color];
+            size_t count = colorOffsets[color + 1] - first;
+            if (count == 0) continue;
+            
+            // The overflow batch may share particles, so it stays serial
+            if (color == MAX_COLORS || count < PARALLEL_BATCH_MIN) {
+                for (size_t k = first; k < first + count; ++k) {
+                    const Contact& contact = coloredContacts[k];
+                    resolveParticleCollision(particles[contact.first], particles[contact.second],
+                                             workerWoken[0]);
+                }
+                continue;
             }
+            
+            workers->run([&](size_t worker) {
+                size_t begin, end;
+                ThreadPool::chunk(count, worker, workers->size(), begin, end);
+                for (size_t k = first + begin; k < first + end; ++k) {
+                    const Contact& contact = coloredContacts[k];
+                    resolveParticleCollision(particles[contact.first], particles[contact.second],
+                                             workerWoken[worker]);
+                }
+            });
         }
     }
+    
+    wokenIslands.clear();
+    for (const auto& woken : workerWoken) {
+        wokenIslands.insert(wokenIslands.end(), woken.begin(), woken.end());
+    }
 }
 
-bool Simulation::checkParticleCollision(const Particle& p1, const Particle& p2) {
-    __m256 diff = _mm256_sub_ps(p1.position, p2.position);
-    __m256 distSq = _mm256_dp_ps(diff, diff, 0x71);
-    float dist;
-    _mm256_store_ps(&dist, distSq);
-    return dist < (PARTICLE_RADIUS * 2.0f) * (PARTICLE_RADIUS * 2.0f);
+template<int Dim>
+bool BasicSimulation<Dim>::checkParticleCollision(const Particle& p1, const Particle& p2) {
+    Vector diff = Simd::sub(p1.position, p2.position);
+    float dist = Simd::dot(diff, diff);
+    float contact = p1.radius + p2.radius;
+    return dist < contact * contact;
 }
 
-void Simulation::resolveParticleCollision(Particle& p1, Particle& p2) {
+template<int Dim>
+void BasicSimulation<Dim>::resolveParticleCollision(Particle& p1, Particle& p2, std::vector<uint32_t>& woken) {
     // Calculate collision normal
-    __m256 diff = _mm256_sub_ps(p2.position, p1.position);
-    __m256 distSq = _mm256_dp_ps(diff, diff, 0x71);
-    float dist;
-    _mm256_store_ps(&dist, distSq);
-    dist = std::sqrt(dist);
+    Vector diff = Simd::sub(p2.position, p1.position);
+    float dist = std::sqrt(Simd::dot(diff, diff));
     
     // Normalize the difference to get collision normal
-    __m256 normal = _mm256_div_ps(diff, _mm256_set1_ps(dist));
+    Vector normal = Simd::div(diff, Simd::splat(dist));
     
     // Calculate relative velocity
-    __m256 relativeVel = _mm256_sub_ps(p2.velocity, p1.velocity);
+    Vector relativeVel = Simd::sub(p2.velocity, p1.velocity);
     
     // Calculate relative velocity along normal
-    __m256 velAlongNormal = _mm256_dp_ps(relativeVel, normal, 0x71);
-    float relativeSpeed;
-    _mm256_store_ps(&relativeSpeed, velAlongNormal);
+    float relativeSpeed = Simd::dot(relativeVel, normal);
     
     // Only resolve collision if particles are moving toward each other
     if (relativeSpeed < 0) {
-        // Calculate impulse scalar
-        __m256 impulse = _mm256_mul_ps(normal, 
-            _mm256_set1_ps(-relativeSpeed * (1.0f + BOUNCE_FACTOR) * 0.5f));
+        // A hard enough hit wakes a sleeper (and with it its whole island)
+        if (-relativeSpeed > WAKE_SPEED) {
+            if (p1.asleep) wakeParticle(p1, woken);
+            if (p2.asleep) wakeParticle(p2, woken);
+        }
+        
+        // A gentle touch leaves the sleeper in place, so it acts as a static
+        // obstacle and the awake particle takes the whole impulse
+        if (p1.asleep || p2.asleep) {
+            Vector impulse = Simd::mul(normal, 
+                Simd::splat(-relativeSpeed * (1.0f + BOUNCE_FACTOR)));
+            if (p1.asleep) {
+                p2.velocity = Simd::add(p2.velocity, impulse);
+            } else {
+                p1.velocity = Simd::sub(p1.velocity, impulse);
+            }
+            return;
+        }
+        
+        // Calculate impulse scalar, split by inverse mass
+        float invMass1 = 1.0f / p1.mass;
+        float invMass2 = 1.0f / p2.mass;
+        float impulseMagnitude = -relativeSpeed * (1.0f + BOUNCE_FACTOR) / (invMass1 + invMass2);
+        Vector impulse = Simd::mul(normal, Simd::splat(impulseMagnitude));
         
         // Apply impulse
-        p1.velocity = _mm256_sub_ps(p1.velocity, impulse);
-        p2.velocity = _mm256_add_ps(p2.velocity, impulse);
+        p1.velocity = Simd::sub(p1.velocity, scaleVector(impulse, invMass1));
+        p2.velocity = Simd::add(p2.velocity, scaleVector(impulse, invMass2));
+    }
+}
+
+template<int Dim>
+uint32_t BasicSimulation<Dim>::findIsland(uint32_t i) {
+    while (islandParent[i] != i) {
+        islandParent[i] = islandParent[islandParent[i]];  // Path halving
+        i = islandParent[i];
     }
-}
\ No newline at end of file
+    return i;
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::mergeIslands(uint32_t a, uint32_t b) {
+    uint32_t rootA = findIsland(a);
+    uint32_t rootB = findIsland(b);
+    if (rootA != rootB) {
+        islandParent[std::max(rootA, rootB)] = std::min(rootA, rootB);
+    }
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::wakeParticle(Particle& p, std::vector<uint32_t>& woken) {
+    p.asleep = false;
+    p.restFrames = 0;
+    woken.push_back(p.islandId);
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::wakeIslands() {
+    if (wokenIslands.empty()) return;
+    
+    std::sort(wokenIslands.begin(), wokenIslands.end());
+    for (auto& p : particles) {
+        if (p.alive && p.asleep && std::binary_search(wokenIslands.begin(), wokenIslands.end(), p.islandId)) {
+            p.asleep = false;
+            p.restFrames = 0;
+        }
+    }
+}
+
+template<int Dim>
+void BasicSimulation<Dim>::updateSleepState(size_t ownedCount, float deltaTime) {
+    // Resting particles on the floor keep bouncing between gravity and the
+    // boundary clamp, so their velocity never settles. Measure the kinetic
+    // energy of how far they actually moved this frame instead, per unit
+    // mass so the test doesn't depend on particle size.
+    float invDtSq = deltaTime > 0.0f ? 1.0f / (deltaTime * deltaTime) : 0.0f;
+    for (size_t i = 0; i < ownedCount; ++i) {
+        Particle& p = particles[i];
+        if (!p.alive || p.asleep) continue;
+        
+        const float* pos = (const float*)&p.position;
+        float displacementSq = 0.0f;
+        for (int axis = 0; axis < Dim; ++axis) {
+            float d = pos[axis] - p.restAnchor[axis];
+            displacementSq += d * d;
+        }
+        float kineticEnergy = 0.5f * displacementSq * invDtSq;
+        
+        // Particles at a slab seam stay awake: the neighbor can't wake them
+        bool atSeam = transport &&
+            (pos[0] < slabLeft + haloWidth || pos[0] >= slabRight - haloWidth);
+        
+        if (kineticEnergy < SLEEP_ENERGY_THRESHOLD && !atSeam) {
+            p.restFrames = std::min<uint16_t>(p.restFrames + 1, SLEEP_FRAMES);
+        } else {
+            p.restFrames = 0;
+        }
+    }
+    
+    // An island sleeps only once every member has been resting long enough.
+    // Ghosts belong to a neighbor, so islands touching them stay awake.
+    islandReady.assign(particles.size(), 1);
+    islandOfRoot.assign(particles.size(), 0);
+    for (size_t i = 0; i < particles.size(); ++i) {
+        const Particle& p = particles[i];
+        uint32_t root = findIsland(static_cast<uint32_t>(i));
+        if (i >= ownedCount || (!p.asleep && p.restFrames < SLEEP_FRAMES)) {
+            islandReady[root] = 0;
+        }
+        if (p.asleep) {
+            islandOfRoot[root] = p.islandId;  // Join the sleepers we rest on
+        }
+    }
+    
+    for (size_t i = 0; i < ownedCount; ++i) {
+        Particle& p = particles[i];
+        uint32_t root = findIsland(static_cast<uint32_t>(i));
+        if (!p.alive || p.asleep || !islandReady[root]) continue;
+        
+        if (islandOfRoot[root] == 0) {
+            islandOfRoot[root] = nextIslandId++;
+        }
+        p.asleep = true;
+        p.islandId = islandOfRoot[root];
+        p.velocity = Simd::zero();
+    }
+}
+
+template class BasicSimulation<2>;
+template class BasicSimulation<3>;
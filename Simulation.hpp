@@ -1,18 +1,112 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <array>
+#include <algorithm>
+#include <random>
 #include "Particle.hpp"
 #include "Octree.hpp"
 #include "SpatialHash.hpp"
+#include "CompressedParticles.hpp"
+#include "Transport.hpp"
+#include "ThreadPool.hpp"
 
-class Simulation {
+// Dim is fixed at compile time and picks the particle layout: 2D runs use
+// 64-byte particles with (x,y) in SSE registers and search 3x3 cells, 3D
+// runs use 96-byte particles with (x,y,z) in AVX registers, search 3x3x3
+// cells and spawn in and collide against the SCREEN_NEAR..SCREEN_FAR depth.
+template<int Dim>
+class BasicSimulation {
+    static_assert(Dim == 2 || Dim == 3, "Only 2D and 3D simulations are supported");
+    
 public:
-    Simulation(size_t numParticles, float gravityValue = -9.81f, 
-              float initialSpeed = 1.0f, float airFriction = 0.47f);
+    using Particle = BasicParticle<Dim>;
+    
+    static constexpr int DIMENSIONS = Dim;
+    
+    // Spawns particles at a fixed point with a base velocity plus random spread
+    struct Emitter {
+        float x, y;
+        float velocityX, velocityY;
+        float spread;   // Random +-spread added to each velocity component
+        float rate;     // Particles per second
+        float radius;
+    };
+    
+    // Removes every particle whose center enters the box (across the full depth in 3D)
+    struct Sink {
+        float left, bottom, right, top;
+    };
+    
+    enum class StorageMode {
+        Full,        // fp32 Particle array
+        Compressed   // CompressedParticles: 16-bit offsets within sorted cells, fp16 velocities
+    };
+    
+    enum class SolverMode {
+        Colored,   // Parallel, one contact color at a time
+        Serial     // Reference: contacts in detection order on the calling thread
+    };
+    
+    static constexpr uint32_t RANDOM_SEED = 0;   // Seed from std::random_device
+    
+    // Runs with the same seed, parameters and solver mode are reproducible
+    BasicSimulation(size_t numParticles, float gravityValue = -9.81f, 
+              float initialSpeed = 1.0f, float airFriction = 0.47f,
+              float minRadius = PARTICLE_RADIUS, float maxRadius = PARTICLE_RADIUS,
+              std::unique_ptr<Transport> transport = nullptr, uint32_t seed = RANDOM_SEED);
     void update(float deltaTime, float speedMultiplier = 1.0f);
-    const std::vector<Particle, AlignedAllocator<Particle>>& getParticles() const {
-        return particles;
-    }
+    // Contains free pool slots too; skip particles that are not alive
+    const std::vector<Particle, AlignedAllocator<Particle>>& getParticles() const;
+    size_t getLiveParticleCount() const { return liveCount; }
+    
+    // Particles live in a fixed pool so emitters and sinks never reallocate
+    // it mid-run. Grow the pool before adding emitters; an emitter whose pool
+    // is exhausted drops particles until sinks free some slots. Periodic
+    // compaction moves live particles to lower slots, so an index only
+    // names the same particle until the next update.
+    void setParticleCapacity(size_t capacity);
+    size_t addEmitter(const Emitter& emitter);
+    size_t addSink(const Sink& sink);
+    
+    void setGravity(float value) { gravity = value; }
+    void setAirFriction(float value) { dragCoefficient = value; }
+    
+    // Collisions are solved in parallel one contact color at a time. Every
+    // color touches each particle at most once, so results don't depend on
+    // the thread count and match a single-threaded run bit for bit. The
+    // serial mode applies contacts in the order they were found instead,
+    // which is the reference the colored solver is checked against.
+    // Changing the thread count moves the particle array so the new workers
+    // fault their own chunks.
+    void setThreadCount(size_t count);
+    // Workers are pinned to CPUs by default; turn it off when sharing the
+    // machine with other pinned processes
+    void setThreadPinning(bool enabled);
+    void setSolverIterations(int iterations) { solverIterations = std::max(1, iterations); }
+    void setSolverMode(SolverMode mode) { solverMode = mode; }
+    SolverMode getSolverMode() const { return solverMode; }
+    
+    // Compressed storage trades precision for bandwidth and memory; switching
+    // records the round-trip error against the fp32 state. Sleeping is not
+    // tracked, and neither domain decomposition nor emitters and sinks are
+    // supported in compressed mode. Compressed storage is 2D only.
+    void setStorageMode(StorageMode mode);
+    StorageMode getStorageMode() const { return storageMode; }
+    const CompressedParticles::Error& getCompressionError() const { return compressionError; }
+    
+    // Drift tracking steps an fp32 copy alongside compressed storage with the
+    // same operations in the same contact order, so getCompressionDrift only
+    // measures what compression adds. It costs a full fp32 copy; enable it
+    // before switching to compressed storage to include the encoding error.
+    void setCompressionDriftTracking(bool enabled);
+    CompressedParticles::Error getCompressionDrift() const;
+    
+    // Domain decomposition: with a transport each process only owns the
+    // particles inside its slab of the X range. gatherParticles is collective
+    // (every rank must call it) and leaves the full particle set on rank 0.
+    bool isDistributed() const { return transport != nullptr; }
+    void gatherParticles(std::vector<Particle, AlignedAllocator<Particle>>& out);
 
 private:
     static constexpr size_t THREAD_COUNT = 8;
@@ -28,46 +122,145 @@ private:
     static constexpr float SCREEN_BOTTOM = -10.0f;
     static constexpr float SCREEN_NEAR = -1.0f;
     static constexpr float SCREEN_FAR = 1.0f;
-    static constexpr float PARTICLE_RADIUS = 0.3f;  // Increased particle size
-    
+    static constexpr float PARTICLE_RADIUS = 0.3f;  // Default size; mass 1 at this radius
+    static constexpr float SLEEP_ENERGY_THRESHOLD = 0.005f;  // Kinetic energy per unit mass that counts as resting
+    static constexpr uint16_t SLEEP_FRAMES = 30;              // Resting frames before an island sleeps
+    static constexpr float WAKE_SPEED = 0.5f;                 // Closing speed that wakes a sleeper
+    static constexpr int MAX_COLORS = 64;                     // One bit per color in particleColors
+    static constexpr size_t PARALLEL_BATCH_MIN = 256;         // Smaller color batches run inline
+    static constexpr int COMPACTION_INTERVAL = 120;           // Frames between compaction checks
+    static constexpr float COMPACTION_THRESHOLD = 0.25f;      // Free share of the active range that triggers it
     float gravity;
     float initialSpeed;
     float dragCoefficient;  // Now a member variable instead of constant
+    float maxRadius;
+    float haloWidth;        // Ghost band at slab edges, one largest diameter
     std::vector<Particle, AlignedAllocator<Particle>> particles;
     std::unique_ptr<Octree> meshOctree;
-    SpatialHash particleHash;
+    BasicSpatialHash<Dim> particleHash;
+    
+    StorageMode storageMode = StorageMode::Full;
+    CompressedParticles compressedParticles;
+    CompressedParticles::Error compressionError;
+    mutable std::vector<Particle, AlignedAllocator<Particle>> decodedParticles;
+    bool trackCompressionDrift = false;
+    std::vector<Particle, AlignedAllocator<Particle>> driftReference;  // fp32 copy, in assign order
+    
+    std::unique_ptr<Transport> transport;
+    float slabLeft;
+    float slabRight;
+    std::vector<Particle, AlignedAllocator<Particle>> outgoingLeft;
+    std::vector<Particle, AlignedAllocator<Particle>> outgoingRight;
+    std::vector<Particle, AlignedAllocator<Particle>> incoming;
+    
+    struct Contact {
+        uint32_t first;
+        uint32_t second;
+    };
+    
+    std::unique_ptr<ThreadPool> workers;
+    bool pinThreads = true;
+    int solverIterations = 1;
+    SolverMode solverMode = SolverMode::Colored;
+    std::vector<std::vector<Contact>> workerContacts;
+    std::vector<std::vector<uint32_t>> workerWoken;
+    std::vector<Contact> contacts;
+    std::vector<Contact> coloredContacts;
+    std::vector<uint8_t> contactColors;
+    std::vector<uint64_t> particleColors;
+    std::array<uint32_t, MAX_COLORS + 2> colorOffsets;
+    
+    // Particle pool: free slots form a min-heap so the lowest is reused
+    // first, and compaction moves live particles to the front so loops stop
+    // at activeEnd
+    std::vector<uint32_t> freeSlots;
+    size_t liveCount = 0;
+    size_t activeEnd = 0;
+    int framesSinceCompaction = 0;
+    std::vector<Emitter> emitters;
+    std::vector<float> emitterCarry;   // Fractional particles owed by each emitter
+    std::vector<Sink> sinks;
+    std::vector<std::vector<uint32_t>> workerKilled;
+    std::mt19937 spawnRng;
+    
+    // Contact islands, rebuilt from the narrowphase every frame
+    std::vector<uint32_t> islandParent;
+    std::vector<uint32_t> islandOfRoot;
+    std::vector<uint8_t> islandReady;
+    std::vector<uint32_t> wokenIslands;
+    uint32_t nextIslandId = 1;
     
     int numParticles;
     int windowWidth;
     int windowHeight;
 
     void updateParticlesBatch(size_t start, size_t end, float deltaTime);
+    
+    // Moves the particles into fresh storage for capacity particles, faulted
+    // by the workers that own each chunk
+    void reserveParticles(size_t capacity);
+    
+    bool spawnParticle(const Particle& particle, bool growIfFull = false);
+    void killParticle(size_t index);
+    void applySinks();
+    void runEmitters(float deltaTime);
+    void compactParticles();
     void calculateForcesSIMD();
     void handleCollisions();
     
+    void integrateParticle(Particle& p, float deltaTime) const;
+    void updateCompressed(float deltaTime);
+    void releaseFrameBuffers();
+    void handleCompressedCollisions();
+    
+    void exchangeWithNeighbor(int peer,
+                              const std::vector<Particle, AlignedAllocator<Particle>>& outgoing,
+                              std::vector<Particle, AlignedAllocator<Particle>>& received);
+    void migrateParticles();
+    void exchangeHalo();
+    
     void handleScreenBoundaries(Particle& p);
-    void handleParticleCollisions(size_t startIdx, size_t endIdx);
+    void findContacts(size_t startIdx, size_t endIdx, std::vector<Contact>& out);
+    void findGhostContacts(size_t startIdx, size_t endIdx, size_t ownedCount, std::vector<Contact>& out);
+    // Scans owned particles below scanEnd, then ghosts from ownedCount on
+    void detectContacts(size_t scanEnd, size_t ownedCount);
+    void colorContacts();
+    void solveContacts();
+    void solveContactsSerial();
     bool checkParticleCollision(const Particle& p1, const Particle& p2);
-    void resolveParticleCollision(Particle& p1, Particle& p2);
+    void resolveParticleCollision(Particle& p1, Particle& p2, std::vector<uint32_t>& woken);
+    
+    uint32_t findIsland(uint32_t i);
+    void mergeIslands(uint32_t a, uint32_t b);
+    void wakeParticle(Particle& p, std::vector<uint32_t>& woken);
+    void wakeIslands();
+    void updateSleepState(size_t ownedCount, float deltaTime);
+    
+    // Constant density: mass scales with the disk area in 2D, the ball volume in 3D
+    static float massFor(float radius) {
+        float relativeSize = radius / PARTICLE_RADIUS;
+        return Dim == 2 ? relativeSize * relativeSize : relativeSize * relativeSize * relativeSize;
+    }
     
     // SIMD helper methods
-    static inline float getY(__m256 v) {
-        float tmp[8];
-        _mm256_store_ps(tmp, v);
-        return tmp[1];
+    using Simd = typename Particle::Simd;
+    using Vector = typename Simd::Vector;
+    
+    static inline float getY(Vector v) {
+        return reinterpret_cast<const float*>(&v)[1];
     }
     
-    static inline void setY(__m256& v, float y) {
-        float tmp[8];
-        _mm256_store_ps(tmp, v);
-        tmp[1] = y;
-        v = _mm256_load_ps(tmp);
+    static inline void setY(Vector& v, float y) {
+        reinterpret_cast<float*>(&v)[1] = y;
     }
     
-    static inline __m256 scaleVector(__m256 v, float scale) {
-        return _mm256_mul_ps(v, _mm256_set1_ps(scale));
+    static inline Vector scaleVector(Vector v, float scale) {
+        return Simd::mul(v, Simd::splat(scale));
     }
 
     // Helper for calculating air resistance
-    __m256 calculateAirResistance(const __m256& velocity, float deltaTime) const;
+    Vector calculateAirResistance(const Vector& velocity, float deltaTime) const;
 };
+
+using Simulation = BasicSimulation<2>;
+using Simulation3D = BasicSimulation<3>;
@@ -1,22 +1,33 @@
 #include "SpatialHash.hpp"
+#include "CompressedParticles.hpp"
 #include <cmath>
 #include <iostream>
 #include <stdexcept>
+#include <algorithm>
 
-SpatialHash::SpatialHash() {
-    std::cout << "Creating default SpatialHash" << std::endl;
-    grid.reserve(1000);
+template<int Dim>
+BasicSpatialHash<Dim>::BasicSpatialHash() {
+    expectedCells = 1000;
 }
 
-SpatialHash::SpatialHash(size_t size) {
-    std::cout << "Creating SpatialHash with size " << size << std::endl;
-    grid.reserve(size);
+template<int Dim>
+BasicSpatialHash<Dim>::BasicSpatialHash(size_t size, float finestCellSize)
+    : finestCellSize(finestCellSize) {
+    if (!(finestCellSize > 0.0f)) {
+        throw std::invalid_argument("Spatial hash cell size must be positive");
+    }
+    expectedCells = size;
 }
 
-void SpatialHash::update(const std::vector<Particle, AlignedAllocator<Particle>>& particles) {
+template<int Dim>
+void BasicSpatialHash<Dim>::update(const std::vector<Particle, AlignedAllocator<Particle>>& particles) {
     try {
-        grid.clear();
+        clear(particles.size());
         for (size_t i = 0; i < particles.size(); ++i) {
+            if (!particles[i].alive) continue;  // Free pool slot
+            int level = levelFor(particles[i].radius);
+            particleLevels[i] = static_cast<uint8_t>(level);
+            
             const float* pos = reinterpret_cast<const float*>(&particles[i].position);
             if (!pos) {
                 throw std::runtime_error("Invalid position pointer");
@@ -28,15 +39,10 @@ void SpatialHash::update(const std::vector<Particle, AlignedAllocator<Particle>>
                 continue;
             }
             
-            uint64_t hash = hashPosition(particles[i].position);
-            grid[hash].push_back(i);
-        }
-        
-        // Debug output
-        if (!particles.empty()) {
-            const float* firstPos = reinterpret_cast<const float*>(&particles[0].position);
-            std::cout << "\rFirst particle at: (" << firstPos[0] << ", " << firstPos[1] 
-                      << ", " << firstPos[2] << ")" << std::flush;
+            uint64_t hash = hashPosition(particles[i].position, level);
+            grids[level][hash].push_back(i);
+            levelMaxRadius[level] = std::max(levelMaxRadius[level], particles[i].radius);
+            occupiedLevels |= 1u << level;
         }
     }
     catch (const std::exception& e) {
@@ -45,9 +51,61 @@ void SpatialHash::update(const std::vector<Particle, AlignedAllocator<Particle>>
     }
 }
 
-std::vector<size_t> SpatialHash::getNearbyParticles(const Particle& particle, float radius) {
-    std::vector<size_t> nearby;
-    nearby.reserve(27); // Reserve space for 3x3x3 neighborhood
+template<int Dim>
+void BasicSpatialHash<Dim>::update(const CompressedParticles& particles) {
+    if (Dim != 2) {
+        throw std::logic_error("Compressed particles are 2D only");
+    }
+    
+    clear(particles.size());
+    for (size_t cell = 0; cell < particles.cellCount(); ++cell) {
+        int x = particles.cellXAt(cell);
+        int y = particles.cellYAt(cell);
+        for (size_t i = particles.cellBegin(cell); i < particles.cellEnd(cell); ++i) {
+            float radius = particles.radiusOf(i);
+            int level = levelFor(radius);
+            particleLevels[i] = static_cast<uint8_t>(level);
+            
+            // Cells double per level, so coarser cells are a shift of the
+            // stored cell (the caller encodes with cellSize(0))
+            grids[level][cellKey(x >> level, y >> level)].push_back(i);
+            levelMaxRadius[level] = std::max(levelMaxRadius[level], radius);
+            occupiedLevels |= 1u << level;
+        }
+    }
+}
+
+template<int Dim>
+void BasicSpatialHash<Dim>::clear(size_t particleCount) {
+    releaseFrameStorage();
+    grids[0].reserve(std::min(expectedCells, particleCount));
+    levelMaxRadius.fill(0.0f);
+    occupiedLevels = 0;
+    particleLevels.resize(particleCount);
+}
+
+template<int Dim>
+void BasicSpatialHash<Dim>::releaseFrameStorage() {
+    // Fresh maps rather than clear(): clear() keeps the bucket array, which
+    // lives in the arena that is about to be reset
+    for (auto& grid : grids) {
+        grid = Grid();
+    }
+}
+
+template<int Dim>
+int BasicSpatialHash<Dim>::levelFor(float radius) const {
+    int level = 0;
+    while (level < LEVEL_COUNT - 1 && 2.0f * radius > cellSize(level)) {
+        ++level;
+    }
+    return level;
+}
+
+template<int Dim>
+typename BasicSpatialHash<Dim>::IndexList BasicSpatialHash<Dim>::getNearbyParticles(const Particle& particle, float radius) const {
+    IndexList nearby;
+    nearby.reserve(STENCIL_CELLS);
     
     try {
         const float* pos = reinterpret_cast<const float*>(&particle.position);
@@ -55,26 +113,9 @@ std::vector<size_t> SpatialHash::getNearbyParticles(const Particle& particle, fl
             throw std::runtime_error("Invalid position pointer in getNearbyParticles");
         }
         
-        // Calculate cell range based on radius
-        int cellRadius = static_cast<int>(std::ceil(radius / CELL_SIZE));
-        
-        // Get base cell coordinates
-        int baseX = static_cast<int>(std::floor(pos[0] / CELL_SIZE));
-        int baseY = static_cast<int>(std::floor(pos[1] / CELL_SIZE));
-        
-        // Check neighboring cells
-        for (int x = -cellRadius; x <= cellRadius; ++x) {
-            for (int y = -cellRadius; y <= cellRadius; ++y) {
-                int cellX = baseX + x;
-                int cellY = baseY + y;
-                
-                uint64_t hash = (static_cast<uint64_t>(cellX) << 32) | 
-                               static_cast<uint64_t>(cellY);
-                
-                auto it = grid.find(hash);
-                if (it != grid.end()) {
-                    nearby.insert(nearby.end(), it->second.begin(), it->second.end());
-                }
+        for (int level = 0; level < LEVEL_COUNT; ++level) {
+            if (occupiedLevels & (1u << level)) {
+                gatherCells(level, pos, radius, nearby);
             }
         }
     }
@@ -86,21 +127,69 @@ std::vector<size_t> SpatialHash::getNearbyParticles(const Particle& particle, fl
     return nearby;
 }
 
-uint64_t SpatialHash::hashPosition(const __m256& position) {
+template<int Dim>
+typename BasicSpatialHash<Dim>::IndexList BasicSpatialHash<Dim>::getCollisionCandidates(size_t index, const Particle& particle) const {
+    IndexList candidates;
+    candidates.reserve(STENCIL_CELLS);
+    
+    const float* pos = reinterpret_cast<const float*>(&particle.position);
+    for (int level = particleLevels[index]; level < LEVEL_COUNT; ++level) {
+        if (occupiedLevels & (1u << level)) {
+            // Both radii fit in this level's cells, so this stays one ring of cells
+            gatherCells(level, pos, particle.radius + levelMaxRadius[level], candidates);
+        }
+    }
+    return candidates;
+}
+
+template<int Dim>
+void BasicSpatialHash<Dim>::gatherCells(int level, const float* pos, float reach, IndexList& out) const {
+    float size = cellSize(level);
+    
+    // Calculate cell range based on radius
+    int cellRadius = static_cast<int>(std::ceil(reach / size));
+    
+    // Get base cell coordinates
+    int baseX = static_cast<int>(std::floor(pos[0] / size));
+    int baseY = static_cast<int>(std::floor(pos[1] / size));
+    int baseZ = Dim == 3 ? static_cast<int>(std::floor(pos[2] / size)) : 0;
+    int depth = Dim == 3 ? cellRadius : 0;  // 2D stays in one layer
+    
+    // Check neighboring cells
+    const auto& grid = grids[level];
+    for (int x = -cellRadius; x <= cellRadius; ++x) {
+        for (int y = -cellRadius; y <= cellRadius; ++y) {
+            for (int z = -depth; z <= depth; ++z) {
+                auto it = grid.find(cellKey(baseX + x, baseY + y, baseZ + z));
+                if (it != grid.end()) {
+                    out.insert(out.end(), it->second.begin(), it->second.end());
+                }
+            }
+        }
+    }
+}
+
+template<int Dim>
+uint64_t BasicSpatialHash<Dim>::hashPosition(const typename Particle::Simd::Vector& position, int level) {
     const float* pos = reinterpret_cast<const float*>(&position);
     if (!pos) {
         throw std::runtime_error("Invalid position pointer in hashPosition");
     }
     
     // Add bounds checking
-    if (std::isnan(pos[0]) || std::isnan(pos[1])) {
+    if (std::isnan(pos[0]) || std::isnan(pos[1]) || (Dim == 3 && std::isnan(pos[2]))) {
         throw std::runtime_error("NaN position detected in hashPosition");
     }
     
     // Convert position to cell coordinates
-    int x = static_cast<int>(std::floor(pos[0] / CELL_SIZE));
-    int y = static_cast<int>(std::floor(pos[1] / CELL_SIZE));
+    float size = cellSize(level);
+    int x = static_cast<int>(std::floor(pos[0] / size));
+    int y = static_cast<int>(std::floor(pos[1] / size));
+    int z = Dim == 3 ? static_cast<int>(std::floor(pos[2] / size)) : 0;
     
-    // Combine x and y into a single 64-bit hash
-    return (static_cast<uint64_t>(x) << 32) | static_cast<uint64_t>(y);
-}
\ No newline at end of file
+    // Combine the cell coordinates into a single 64-bit hash
+    return cellKey(x, y, z);
+}
+
+template class BasicSpatialHash<2>;
+template class BasicSpatialHash<3>;
\ No newline at end of file
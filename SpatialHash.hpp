@@ -1,20 +1,85 @@
 #pragma once
 #include <vector>
+#include <array>
 #include <unordered_map>
 #include "Particle.hpp"
+#include "Arena.hpp"
 
-class SpatialHash {
+class CompressedParticles;
+
+// Hierarchical grid: level L has cells of finestCellSize * 2^L and holds the
+// particles whose diameter fits in one of its cells. A collision query only
+// looks at the particle's own level and the coarser ones, so it touches a
+// 3x3 block (3x3x3 in 3D) per occupied level no matter how much the radii
+// vary; pairs with smaller particles are found from the smaller particle's side.
+//
+// Dim is fixed at compile time: the 2D grid ignores z entirely, the 3D grid
+// bins and searches along z as well.
+template<int Dim>
+class BasicSpatialHash {
+    static_assert(Dim == 2 || Dim == 3, "Only 2D and 3D grids are supported");
+    
 public:
-    static constexpr float CELL_SIZE = 1.0f;
+    using Particle = BasicParticle<Dim>;
+    
+    static constexpr int DIMENSIONS = Dim;
+    static constexpr float CELL_SIZE = 1.0f;   // Default finest level
+    static constexpr int LEVEL_COUNT = 8;
+    static constexpr size_t STENCIL_CELLS = Dim == 2 ? 9 : 27;
     
-    SpatialHash();
-    SpatialHash(size_t size);  // Add new constructor
+    // Query results live in the calling thread's FrameArena
+    using IndexList = std::vector<size_t, FrameAllocator<size_t>>;
+    
+    BasicSpatialHash();
+    // Pick a finest cell about one smallest diameter wide, or small particles
+    // crowd into the same cells and every query returns all of them
+    BasicSpatialHash(size_t size, float finestCellSize = CELL_SIZE);
     
     void update(const std::vector<Particle, AlignedAllocator<Particle>>& particles);
-    std::vector<size_t> getNearbyParticles(const Particle& particle, float radius);
+    void update(const CompressedParticles& particles);  // Bins by the stored cell (2D only)
+    
+    // Every particle whose center may lie within radius of the particle's center
+    IndexList getNearbyParticles(const Particle& particle, float radius) const;
+    // Particles on the same or a coarser level that may touch particle index
+    IndexList getCollisionCandidates(size_t index, const Particle& particle) const;
+    
+    // Drops every cell before the frame arenas are reset
+    void releaseFrameStorage();
+    
+    int getLevel(size_t index) const { return particleLevels[index]; }
+    bool hasCoarserLevels(int level) const { return (occupiedLevels >> (level + 1)) != 0; }
+    
+    int levelFor(float radius) const;
+    float cellSize(int level) const { return finestCellSize * static_cast<float>(1 << level); }
     
 private:
-    std::unordered_map<uint64_t, std::vector<size_t>> grid;
+    // Cells are rebuilt every frame, so they are allocated from the FrameArena
+    using Grid = std::unordered_map<uint64_t, IndexList, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                                    FrameAllocator<std::pair<const uint64_t, IndexList>>>;
+    
+    std::array<Grid, LEVEL_COUNT> grids;
+    size_t expectedCells;
+    float finestCellSize = CELL_SIZE;
+    std::array<float, LEVEL_COUNT> levelMaxRadius{};
+    uint32_t occupiedLevels = 0;
+    std::vector<uint8_t> particleLevels;
     
-    uint64_t hashPosition(const __m256& position);
+    void clear(size_t particleCount);
+    void gatherCells(int level, const float* pos, float reach, IndexList& out) const;
+    uint64_t hashPosition(const typename Particle::Simd::Vector& position, int level);
+    
+    // 2D keys pack two 32-bit coordinates, 3D keys three 21-bit ones
+    static uint64_t cellKey(int x, int y, int z = 0) {
+        if constexpr (Dim == 2) {
+            return (static_cast<uint64_t>(x) << 32) | static_cast<uint32_t>(y);
+        } else {
+            constexpr uint64_t mask = (uint64_t(1) << 21) - 1;
+            return ((static_cast<uint64_t>(x) & mask) << 42) |
+                   ((static_cast<uint64_t>(y) & mask) << 21) |
+                   (static_cast<uint64_t>(z) & mask);
+        }
+    }
 };
+
+using SpatialHash = BasicSpatialHash<2>;
+using SpatialHash3D = BasicSpatialHash<3>;
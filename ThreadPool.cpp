@@ -0,0 +1,93 @@
+#include "ThreadPool.hpp"
+#include "Arena.hpp"
+#include <cstdint>
+#include <stdexcept>
+
+ThreadPool::ThreadPool(size_t threadCount, bool pinThreads) {
+    if (threadCount == 0) {
+        throw std::invalid_argument("Thread pool needs at least one thread");
+    }
+    workers.reserve(threadCount);
+    for (size_t t = 0; t < threadCount; ++t) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, t, threadCount, pinThreads);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::firstTouch(void* data, size_t count, size_t elementSize) {
+    if (!data || count == 0) return;
+    
+    uintptr_t base = reinterpret_cast<uintptr_t>(data);
+    uintptr_t limit = base + count * elementSize;
+    size_t workerCount = workers.size();
+    run([&](size_t worker) {
+        size_t begin, end;
+        chunk(count, worker, workerCount, begin, end);
+        // Page starts inside [first, last); the last worker also takes the
+        // partial page at the very end
+        uintptr_t first = base + begin * elementSize;
+        uintptr_t last = worker + 1 == workerCount ? limit : base + end * elementSize;
+        uintptr_t page = (first + HugePageArena::PAGE_SIZE - 1) / HugePageArena::PAGE_SIZE
+                         * HugePageArena::PAGE_SIZE;
+        if (worker == 0) page = base;
+        for (; page < last; page += HugePageArena::PAGE_SIZE) {
+            *reinterpret_cast<volatile char*>(page) = 0;
+        }
+    });
+}
+
+void ThreadPool::runTask(const void* context, Invoker invoke) {
+    std::unique_lock<std::mutex> lock(mutex);
+    taskContext = context;
+    invokeTask = invoke;
+    pending = workers.size();
+    error = nullptr;
+    ++generation;
+    taskReady.notify_all();
+    taskDone.wait(lock, [this] { return pending == 0; });
+    taskContext = nullptr;
+    invokeTask = nullptr;
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::workerLoop(size_t worker, size_t workerCount, bool pinThread) {
+    if (pinThread) HugePageArena::pinToWorkerCpu(worker, workerCount);
+
+    uint64_t seen = 0;
+    while (true) {
+        const void* context;
+        Invoker invoke;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskReady.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            context = taskContext;
+            invoke = invokeTask;
+        }
+
+        std::exception_ptr failure;
+        try {
+            invoke(context, worker);
+        } catch (...) {
+            failure = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (failure && !error) error = failure;
+        if (--pending == 0) taskDone.notify_one();
+    }
+}
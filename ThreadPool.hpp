@@ -0,0 +1,60 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, pinned to CPUs unless disabled. Worker t
+// always gets the t-th chunk of a static split, which keeps its data on the
+// NUMA node it first touched.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount, bool pinThreads = true);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    // Runs task(worker) once on every worker and waits for all of them.
+    // The first exception thrown by a worker is rethrown here. The task is
+    // called through a plain pointer, so lambdas are never copied to the heap.
+    template<typename Task>
+    void run(const Task& task) {
+        runTask(&task, [](const void* context, size_t worker) {
+            (*static_cast<const Task*>(context))(worker);
+        });
+    }
+
+    // Items [begin, end) of count that worker owns under the static split
+    static void chunk(size_t count, size_t worker, size_t workerCount,
+                      size_t& begin, size_t& end) {
+        begin = count * worker / workerCount;
+        end = count * (worker + 1) / workerCount;
+    }
+
+    // Writes one byte to every page of fresh, unfaulted storage from the
+    // worker whose chunk of the count elements holds the start of that page,
+    // so the pages land on that worker's node. The contents are not
+    // preserved; call it before anything is stored.
+    void firstTouch(void* data, size_t count, size_t elementSize);
+
+private:
+    using Invoker = void (*)(const void* context, size_t worker);
+    
+    void runTask(const void* context, Invoker invoke);
+    void workerLoop(size_t worker, size_t workerCount, bool pinThread);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable taskReady;
+    std::condition_variable taskDone;
+    const void* taskContext = nullptr;
+    Invoker invokeTask = nullptr;
+    uint64_t generation = 0;
+    size_t pending = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+};
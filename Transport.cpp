@@ -0,0 +1,129 @@
+#include "Transport.hpp"
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <array>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static void sendAll(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EPIPE || errno == ECONNRESET) {
+                throw TransportClosed("Peer closed connection");
+            }
+            throw std::runtime_error(std::string("Socket send failed: ") + std::strerror(errno));
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+static void receiveAll(int fd, void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t received = ::recv(fd, bytes, size, 0);
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ECONNRESET) {
+                throw TransportClosed("Peer closed connection");
+            }
+            throw std::runtime_error(std::string("Socket receive failed: ") + std::strerror(errno));
+        }
+        if (received == 0) {
+            throw TransportClosed("Peer closed connection");
+        }
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+}
+
+std::unique_ptr<UnixSocketTransport> UnixSocketTransport::spawn(int numRanks) {
+    if (numRanks < 1) {
+        throw std::invalid_argument("Rank count must be at least 1");
+    }
+
+    // links[k] connects rank k (end 0) with rank k + 1 (end 1)
+    std::vector<std::array<int, 2>> links(numRanks - 1);
+    for (auto& link : links) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            throw std::runtime_error(std::string("socketpair failed: ") + std::strerror(errno));
+        }
+        link = {fds[0], fds[1]};
+    }
+
+    std::vector<pid_t> children;
+    int rank = 0;
+    for (int r = 1; r < numRanks; ++r) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            throw std::runtime_error(std::string("fork failed: ") + std::strerror(errno));
+        }
+        if (pid == 0) {
+            rank = r;
+            children.clear();
+            break;
+        }
+        children.push_back(pid);
+    }
+
+    // Keep only the two socket ends that belong to this rank
+    int left = -1;
+    int right = -1;
+    for (int k = 0; k < numRanks - 1; ++k) {
+        if (k == rank - 1) {
+            left = links[k][1];
+            close(links[k][0]);
+        } else if (k == rank) {
+            right = links[k][0];
+            close(links[k][1]);
+        } else {
+            close(links[k][0]);
+            close(links[k][1]);
+        }
+    }
+
+    std::unique_ptr<UnixSocketTransport> transport(
+        new UnixSocketTransport(rank, numRanks, left, right));
+    transport->children = std::move(children);
+    return transport;
+}
+
+UnixSocketTransport::UnixSocketTransport(int rank, int size, int leftFd, int rightFd)
+    : rankId(rank),
+      rankCount(size),
+      leftSocket(leftFd),
+      rightSocket(rightFd)
+{
+}
+
+UnixSocketTransport::~UnixSocketTransport() {
+    // Closing our ends makes the neighbors see TransportClosed, which
+    // cascades down the chain and lets every worker exit.
+    if (leftSocket >= 0) close(leftSocket);
+    if (rightSocket >= 0) close(rightSocket);
+
+    for (pid_t child : children) {
+        waitpid(child, nullptr, 0);
+    }
+}
+
+int UnixSocketTransport::socketFor(int peer) const {
+    if (peer == rankId - 1 && leftSocket >= 0) return leftSocket;
+    if (peer == rankId + 1 && rightSocket >= 0) return rightSocket;
+    throw std::invalid_argument("Rank " + std::to_string(rankId) +
+                                " has no connection to rank " + std::to_string(peer));
+}
+
+void UnixSocketTransport::sendBytes(int peer, const void* data, size_t size) {
+    sendAll(socketFor(peer), data, size);
+}
+
+void UnixSocketTransport::receiveBytes(int peer, void* data, size_t size) {
+    receiveAll(socketFor(peer), data, size);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <cstdint>
+#include <type_traits>
+#include <sys/types.h>
+#include "Particle.hpp"
+
+// Thrown when the process on the other end of a transport has gone away,
+// which is how worker ranks learn that the run is over.
+class TransportClosed : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Moves particles between the processes of a domain-decomposed simulation.
+// Every rank owns one slab of the domain and only ever talks to the ranks
+// owning the neighboring slabs.
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    virtual int rank() const = 0;
+    virtual int size() const = 0;
+
+    // Particles travel as raw bytes behind their count, so both layouts
+    // share one transport; each rank runs the same dimension
+    template<int Dim>
+    void send(int peer, const std::vector<BasicParticle<Dim>, AlignedAllocator<BasicParticle<Dim>>>& particles) {
+        static_assert(std::is_trivially_copyable<BasicParticle<Dim>>::value,
+                      "Particles are sent over sockets as raw bytes");
+        uint64_t count = particles.size();
+        sendBytes(peer, &count, sizeof(count));
+        if (count > 0) {
+            sendBytes(peer, particles.data(), count * sizeof(BasicParticle<Dim>));
+        }
+    }
+
+    template<int Dim>
+    void receive(int peer, std::vector<BasicParticle<Dim>, AlignedAllocator<BasicParticle<Dim>>>& particles) {
+        uint64_t count = 0;
+        receiveBytes(peer, &count, sizeof(count));
+        particles.resize(count);
+        if (count > 0) {
+            receiveBytes(peer, particles.data(), count * sizeof(BasicParticle<Dim>));
+        }
+    }
+
+protected:
+    virtual void sendBytes(int peer, const void* data, size_t size) = 0;
+    virtual void receiveBytes(int peer, void* data, size_t size) = 0;
+};
+
+// Transport over AF_UNIX socketpairs between forked processes on one machine.
+class UnixSocketTransport : public Transport {
+public:
+    // Forks numRanks - 1 worker processes chained together by socketpairs.
+    // Returns in every process with the transport for that process' rank;
+    // the calling process becomes rank 0.
+    static std::unique_ptr<UnixSocketTransport> spawn(int numRanks);
+
+    ~UnixSocketTransport() override;
+    UnixSocketTransport(const UnixSocketTransport&) = delete;
+    UnixSocketTransport& operator=(const UnixSocketTransport&) = delete;
+
+    int rank() const override { return rankId; }
+    int size() const override { return rankCount; }
+
+protected:
+    void sendBytes(int peer, const void* data, size_t size) override;
+    void receiveBytes(int peer, void* data, size_t size) override;
+
+private:
+    UnixSocketTransport(int rank, int size, int leftFd, int rightFd);
+
+    int socketFor(int peer) const;
+
+    int rankId;
+    int rankCount;
+    int leftSocket;
+    int rightSocket;
+    std::vector<pid_t> children;  // Only populated on rank 0
+};
@@ -1,8 +1,93 @@
 #include <chrono>
 #include <iostream>
+#include <sstream>
 #include "Simulation.hpp"
 #include "PerformanceMonitor.hpp"
 #include "Renderer.hpp"
+#include "Transport.hpp"
+
+// Prints the compressed layout and its encoding error, then steps a copy of
+// the scene in compressed storage with drift tracking and reports how far it
+// has moved from the fp32 reference run through the same contacts
+static void reportCompression(const Simulation& sim, size_t numParticles, float gravity,
+                              float initialSpeed, float airFriction, float minRadius,
+                              float maxRadius, uint32_t seed) {
+    static constexpr int DRIFT_FRAMES = 120;
+    
+    const auto& error = sim.getCompressionError();
+    std::cout << "Compressed storage: " << CompressedParticles::bytesPerParticle()
+              << " bytes/particle + " << CompressedParticles::bytesPerCell()
+              << " per occupied cell (fp32 SoA: " << CompressedParticles::fp32BytesPerParticle()
+              << ")" << std::endl
+              << "  Encoding position error max/rms: " << error.maxPosition << " / " << error.rmsPosition << std::endl
+              << "  Encoding velocity error max/rms: " << error.maxVelocity << " / " << error.rmsVelocity << std::endl;
+    
+    Simulation compressed(numParticles, gravity, initialSpeed, airFriction,
+                          minRadius, maxRadius, nullptr, seed);
+    compressed.setCompressionDriftTracking(true);
+    compressed.setStorageMode(Simulation::StorageMode::Compressed);
+    for (int frame = 0; frame < DRIFT_FRAMES; ++frame) {
+        compressed.update(1.0f / 60.0f);
+    }
+    
+    auto drift = compressed.getCompressionDrift();
+    std::cout << "  Drift after " << DRIFT_FRAMES << " frames, position max/rms: "
+              << drift.maxPosition << " / " << drift.rmsPosition << std::endl
+              << "  Drift after " << DRIFT_FRAMES << " frames, velocity max/rms: "
+              << drift.maxVelocity << " / " << drift.rmsVelocity << std::endl;
+}
+
+// Sets up the optional particle stream, then runs the viewer (or a headless
+// worker loop) until the window closes
+template<int Dim>
+static void run(BasicSimulation<Dim>& sim, bool isWorker, bool particleStream,
+                size_t numParticles, float minRadius) {
+    if (particleStream) {
+        // Pool room for the stream on top of the initial particles
+        sim.setParticleCapacity(sim.getParticles().size() + numParticles + 1000);
+        sim.addEmitter({-9.0f, 8.0f, 6.0f, 0.0f, 0.5f, 120.0f, minRadius});
+        sim.addSink({7.0f, -10.0f, 10.0f, -7.0f});
+    }
+    using Particle = typename BasicSimulation<Dim>::Particle;
+    std::vector<Particle, AlignedAllocator<Particle>> allParticles;
+    
+    // Worker ranks run headless until rank 0 shuts the chain down
+    if (isWorker) {
+        while (true) {
+            sim.update(1.0f / 60.0f);
+            sim.gatherParticles(allParticles);
+        }
+    }
+    
+    PerformanceMonitor perfMon;
+    Renderer renderer;
+    
+    std::cout << "Initializing Particle Simulation...\n";
+    
+    float speedMultiplier = 1.0f;
+    while (!renderer.shouldClose()) {
+        perfMon.beginFrame();
+        
+        // Speed control with keyboard (workers can't see it, so only
+        // single-process runs honor it)
+        if (!sim.isDistributed()) {
+            if (renderer.isKeyPressed('Q')) speedMultiplier *= 1.1f;
+            if (renderer.isKeyPressed('E')) speedMultiplier *= 0.9f;
+        }
+        
+        sim.update(1.0f / 60.0f, speedMultiplier);
+        if (sim.isDistributed()) {
+            sim.gatherParticles(allParticles);
+            renderer.render(allParticles);
+        } else {
+            renderer.render(sim.getParticles());
+        }
+        
+        perfMon.endFrame();
+    }
+    
+    perfMon.printMetrics();
+}
 
 int main() {
     // Get gravity input
@@ -24,6 +109,58 @@ int main() {
     std::getline(std::cin, input);
     airFriction = input.empty() ? 0.47f : std::stof(input);
 
+    // Get particle radius range
+    float minRadius, maxRadius;
+    std::cout << "Enter particle radius range as min max (default 0.3 0.3): ";
+    std::getline(std::cin, input);
+    {
+        std::istringstream radii(input);
+        if (!(radii >> minRadius)) minRadius = 0.3f;
+        if (!(radii >> maxRadius)) maxRadius = minRadius;
+    }
+
+    // Get process count for domain decomposition
+    int numProcesses;
+    std::cout << "Enter number of processes (default 1): ";
+    std::getline(std::cin, input);
+    numProcesses = input.empty() ? 1 : std::stoi(input);
+
+    // Get dimension count
+    int dimensions;
+    std::cout << "Enter dimensions, 2 or 3 (default 2): ";
+    std::getline(std::cin, input);
+    dimensions = input.empty() ? 2 : std::stoi(input);
+    if (dimensions != 2 && dimensions != 3) {
+        std::cerr << "Error: dimensions must be 2 or 3" << std::endl;
+        return 1;
+    }
+
+    // Get storage mode (2D only)
+    bool compressedStorage = false;
+    if (dimensions == 2) {
+        std::cout << "Use compressed particle storage? (y/N): ";
+        std::getline(std::cin, input);
+        compressedStorage = !input.empty() && (input[0] == 'y' || input[0] == 'Y');
+    }
+    if (compressedStorage && numProcesses > 1) {
+        std::cerr << "Error: compressed storage does not support multiple processes" << std::endl;
+        return 1;
+    }
+
+    // Get emitter/sink stream (needs fp32 storage)
+    bool particleStream = false;
+    if (!compressedStorage) {
+        std::cout << "Enable particle stream? (y/N): ";
+        std::getline(std::cin, input);
+        particleStream = !input.empty() && (input[0] == 'y' || input[0] == 'Y');
+    }
+
+    // Get random seed
+    uint32_t seed;
+    std::cout << "Enter random seed (default random): ";
+    std::getline(std::cin, input);
+    seed = input.empty() ? Simulation::RANDOM_SEED : static_cast<uint32_t>(std::stoul(input));
+
     // Get particle count without arbitrary limits
     size_t numParticles;
     do {
@@ -39,29 +176,39 @@ int main() {
         break;
     } while (true);
 
+    std::cout << "Initializing simulation with parameters:" << std::endl
+              << "Particles: " << numParticles << " (" << dimensions << "D)" << std::endl
+              << "Gravity: " << gravity << std::endl
+              << "Speed: " << initialSpeed << std::endl
+              << "Friction: " << airFriction << std::endl
+              << "Radius: " << minRadius << " - " << maxRadius << std::endl;
+
+    std::unique_ptr<Transport> transport;
+    if (numProcesses > 1) {
+        transport = UnixSocketTransport::spawn(numProcesses);
+    }
+    const bool isWorker = transport && transport->rank() != 0;
+
     try {
-        Simulation sim(numParticles, gravity, initialSpeed, airFriction);
-        PerformanceMonitor perfMon;
-        Renderer renderer;
-        
-        std::cout << "Initializing Particle Simulation...\n";
-        
-        float speedMultiplier = 1.0f;
-        while (!renderer.shouldClose()) {
-            perfMon.beginFrame();
-            
-            // Speed control with keyboard
-            if (renderer.isKeyPressed('Q')) speedMultiplier *= 1.1f;
-            if (renderer.isKeyPressed('E')) speedMultiplier *= 0.9f;
-            
-            sim.update(1.0f / 60.0f, speedMultiplier);
-            renderer.render(sim.getParticles());
-            
-            perfMon.endFrame();
+        if (dimensions == 3) {
+            Simulation3D sim(numParticles, gravity, initialSpeed, airFriction,
+                             minRadius, maxRadius, std::move(transport), seed);
+            run(sim, isWorker, particleStream, numParticles, minRadius);
+        } else {
+            Simulation sim(numParticles, gravity, initialSpeed, airFriction,
+                           minRadius, maxRadius, std::move(transport), seed);
+            if (compressedStorage) {
+                sim.setStorageMode(Simulation::StorageMode::Compressed);
+                reportCompression(sim, numParticles, gravity, initialSpeed, airFriction,
+                                  minRadius, maxRadius, seed);
+            }
+            run(sim, isWorker, particleStream, numParticles, minRadius);
         }
         
-        perfMon.printMetrics();
-        
+    } catch (const TransportClosed&) {
+        if (isWorker) return 0;
+        std::cerr << "Error: lost connection to worker processes" << std::endl;
+        return 1;
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
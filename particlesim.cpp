@@ -0,0 +1,259 @@
+#include "particlesim.h"
+#include "Simulation.hpp"
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <variant>
+
+struct ps_simulation {
+    std::variant<Simulation, Simulation3D> sim;
+
+    explicit ps_simulation(const ps_config& config)
+        : sim(make(config)) {}
+
+    // Calls body with the simulation of whichever dimension was configured
+    template<typename Body>
+    void visit(Body&& body) { std::visit(body, sim); }
+    template<typename Body>
+    void visit(Body&& body) const { std::visit(body, sim); }
+
+    bool fullStorage() const {
+        bool full = false;
+        visit([&](const auto& s) { full = s.getStorageMode() == std::decay_t<decltype(s)>::StorageMode::Full; });
+        return full;
+    }
+
+private:
+    static std::variant<Simulation, Simulation3D> make(const ps_config& config) {
+        if (config.dimensions == 3) {
+            return std::variant<Simulation, Simulation3D>(
+                std::in_place_index<1>, config.particle_count, config.gravity, config.initial_speed,
+                config.air_friction, config.min_radius, config.max_radius, nullptr, config.seed);
+        }
+        return std::variant<Simulation, Simulation3D>(
+            std::in_place_index<0>, config.particle_count, config.gravity, config.initial_speed,
+            config.air_friction, config.min_radius, config.max_radius, nullptr, config.seed);
+    }
+};
+
+static thread_local std::string lastError;
+
+// Runs body, turning exceptions into status codes at the C boundary
+template<typename Body>
+static ps_status guarded(Body&& body) {
+    try {
+        body();
+        lastError.clear();
+        return PS_OK;
+    } catch (const std::invalid_argument& e) {
+        lastError = e.what();
+        return PS_ERROR_INVALID_ARGUMENT;
+    } catch (const std::logic_error& e) {
+        lastError = e.what();
+        return PS_ERROR_UNSUPPORTED;
+    } catch (const std::exception& e) {
+        lastError = e.what();
+        return PS_ERROR_INTERNAL;
+    } catch (...) {
+        lastError = "Unknown error";
+        return PS_ERROR_INTERNAL;
+    }
+}
+
+// Particle members exposed as views; their offsets depend on the dimension
+enum class Field { Position, Velocity, Radius, Alive };
+
+template<typename SimParticle>
+static size_t fieldOffset(Field field) {
+    switch (field) {
+    case Field::Position: return offsetof(SimParticle, position);
+    case Field::Velocity: return offsetof(SimParticle, velocity);
+    case Field::Radius: return offsetof(SimParticle, radius);
+    case Field::Alive: return offsetof(SimParticle, alive);
+    }
+    throw std::invalid_argument("Unknown particle field");
+}
+
+// Zero-copy view of one member of every particle
+static ps_status particleView(const ps_simulation* sim, Field field, bool vector,
+                              ps_array_view* out) {
+    return guarded([&] {
+        if (!sim || !out) throw std::invalid_argument("Null simulation or output view");
+        if (!sim->fullStorage()) {
+            throw std::logic_error("Zero-copy access needs fp32 storage");
+        }
+
+        sim->visit([&](const auto& s) {
+            using Sim = std::decay_t<decltype(s)>;
+            using SimParticle = typename Sim::Particle;
+            const auto& particles = s.getParticles();
+            out->data = particles.empty() ? nullptr
+                : reinterpret_cast<const float*>(reinterpret_cast<const char*>(particles.data()) +
+                                                 fieldOffset<SimParticle>(field));
+            out->count = particles.size();
+            out->stride = sizeof(SimParticle);
+            out->components = vector ? Sim::DIMENSIONS : 1;
+        });
+    });
+}
+
+extern "C" {
+
+void ps_config_init(ps_config* config) {
+    if (!config) return;
+    config->struct_size = sizeof(ps_config);
+    config->particle_count = 1000;
+    config->gravity = -9.81f;
+    config->initial_speed = 1.0f;
+    config->air_friction = 0.47f;
+    config->min_radius = 0.3f;
+    config->max_radius = 0.3f;
+    config->dimensions = 2;
+    config->seed = 0;
+}
+
+ps_status ps_create(const ps_config* config, ps_simulation** out) {
+    return guarded([&] {
+        if (!config || !out) throw std::invalid_argument("Null config or output pointer");
+        if (config->struct_size != sizeof(ps_config)) {
+            throw std::invalid_argument("Unknown ps_config size; initialize it with ps_config_init");
+        }
+        if (config->dimensions != 2 && config->dimensions != 3) {
+            throw std::invalid_argument("Dimensions must be 2 or 3");
+        }
+        *out = nullptr;
+        *out = new ps_simulation(*config);
+    });
+}
+
+void ps_destroy(ps_simulation* sim) {
+    delete sim;
+}
+
+ps_status ps_step(ps_simulation* sim, float delta_time) {
+    return guarded([&] {
+        if (!sim) throw std::invalid_argument("Null simulation");
+        sim->visit([&](auto& s) { s.update(delta_time); });
+    });
+}
+
+ps_status ps_set_gravity(ps_simulation* sim, float gravity) {
+    return guarded([&] {
+        if (!sim) throw std::invalid_argument("Null simulation");
+        sim->visit([&](auto& s) { s.setGravity(gravity); });
+    });
+}
+
+ps_status ps_set_air_friction(ps_simulation* sim, float air_friction) {
+    return guarded([&] {
+        if (!sim) throw std::invalid_argument("Null simulation");
+        sim->visit([&](auto& s) { s.setAirFriction(air_friction); });
+    });
+}
+
+ps_status ps_set_thread_count(ps_simulation* sim, size_t thread_count) {
+    return guarded([&] {
+        if (!sim) throw std::invalid_argument("Null simulation");
+        if (thread_count == 0) throw std::invalid_argument("Thread count must be at least 1");
+        sim->visit([&](auto& s) { s.setThreadCount(thread_count); });
+    });
+}
+
+ps_status ps_set_thread_pinning(ps_simulation* sim, int enabled) {
+    return guarded([&] {
+        if (!sim) throw std::invalid_argument("Null simulation");
+        sim->visit([&](auto& s) { s.setThreadPinning(enabled != 0); });
+    });
+}
+
+ps_status ps_set_solver_iterations(ps_simulation* sim, int iterations) {
+    return guarded([&] {
+        if (!sim) throw std::invalid_argument("Null simulation");
+        if (iterations < 1) throw std::invalid_argument("Solver needs at least one iteration");
+        sim->visit([&](auto& s) { s.setSolverIterations(iterations); });
+    });
+}
+
+ps_status ps_set_solver_mode(ps_simulation* sim, ps_solver_mode mode) {
+    return guarded([&] {
+        if (!sim) throw std::invalid_argument("Null simulation");
+        if (mode != PS_SOLVER_COLORED && mode != PS_SOLVER_SERIAL) {
+            throw std::invalid_argument("Unknown solver mode");
+        }
+        sim->visit([&](auto& s) {
+            using Sim = std::decay_t<decltype(s)>;
+            s.setSolverMode(mode == PS_SOLVER_SERIAL ? Sim::SolverMode::Serial : Sim::SolverMode::Colored);
+        });
+    });
+}
+
+ps_status ps_set_particle_capacity(ps_simulation* sim, size_t capacity) {
+    return guarded([&] {
+        if (!sim) throw std::invalid_argument("Null simulation");
+        sim->visit([&](auto& s) { s.setParticleCapacity(capacity); });
+    });
+}
+
+ps_status ps_add_emitter(ps_simulation* sim, const ps_emitter* emitter) {
+    return guarded([&] {
+        if (!sim || !emitter) throw std::invalid_argument("Null simulation or emitter");
+        sim->visit([&](auto& s) {
+            s.addEmitter({emitter->x, emitter->y, emitter->velocity_x, emitter->velocity_y,
+                          emitter->spread, emitter->rate, emitter->radius});
+        });
+    });
+}
+
+ps_status ps_add_sink(ps_simulation* sim, const ps_sink* sink) {
+    return guarded([&] {
+        if (!sim || !sink) throw std::invalid_argument("Null simulation or sink");
+        sim->visit([&](auto& s) { s.addSink({sink->left, sink->bottom, sink->right, sink->top}); });
+    });
+}
+
+ps_status ps_get_live_count(const ps_simulation* sim, size_t* out) {
+    return guarded([&] {
+        if (!sim || !out) throw std::invalid_argument("Null simulation or output pointer");
+        sim->visit([&](const auto& s) { *out = s.getLiveParticleCount(); });
+    });
+}
+
+ps_status ps_get_positions(const ps_simulation* sim, ps_array_view* out) {
+    return particleView(sim, Field::Position, true, out);
+}
+
+ps_status ps_get_velocities(const ps_simulation* sim, ps_array_view* out) {
+    return particleView(sim, Field::Velocity, true, out);
+}
+
+ps_status ps_get_radii(const ps_simulation* sim, ps_array_view* out) {
+    return particleView(sim, Field::Radius, false, out);
+}
+
+ps_status ps_get_alive(const ps_simulation* sim, ps_flag_view* out) {
+    return guarded([&] {
+        if (!sim || !out) throw std::invalid_argument("Null simulation or output view");
+        if (!sim->fullStorage()) {
+            throw std::logic_error("Zero-copy access needs fp32 storage");
+        }
+
+        static_assert(sizeof(bool) == 1, "alive flag is exposed as a byte");
+        sim->visit([&](const auto& s) {
+            using SimParticle = typename std::decay_t<decltype(s)>::Particle;
+            const auto& particles = s.getParticles();
+            out->data = particles.empty() ? nullptr
+                : reinterpret_cast<const unsigned char*>(particles.data()) +
+                  fieldOffset<SimParticle>(Field::Alive);
+            out->count = particles.size();
+            out->stride = sizeof(SimParticle);
+        });
+    });
+}
+
+const char* ps_last_error(void) {
+    return lastError.c_str();
+}
+
+}  // extern "C"
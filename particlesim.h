@@ -0,0 +1,120 @@
+#ifndef PARTICLESIM_H
+#define PARTICLESIM_H
+
+/*
+ * C API of libparticlesim.
+ *
+ * Every function returns a ps_status; on failure ps_last_error() describes
+ * what went wrong on the calling thread. State arrays are exposed without
+ * copying: element i of a view starts at (const char*)view.data + i * view.stride
+ * and holds view.components consecutive floats. Views stay valid until the
+ * next call that mutates the simulation (ps_step, ps_destroy). The calls
+ * that move the particle arrays invalidate them as well: ps_set_thread_count,
+ * ps_set_thread_pinning, and ps_set_particle_capacity when it grows the pool.
+ *
+ * With emitters or sinks the views also cover free pool slots; check
+ * ps_get_alive before reading a particle. Growing the pool with
+ * ps_set_particle_capacity up front keeps view data pointers stable across
+ * ps_step. Indices are not stable identities: every 120 steps a pool with
+ * more than a quarter of its active range free is compacted, which moves
+ * live particles to lower indices. Re-read the views after every ps_step
+ * instead of caching per-particle data by index.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ps_simulation ps_simulation;
+
+typedef enum ps_status {
+    PS_OK = 0,
+    PS_ERROR_INVALID_ARGUMENT = 1,
+    PS_ERROR_UNSUPPORTED = 2,   /* e.g. zero-copy access in compressed storage mode */
+    PS_ERROR_INTERNAL = 3
+} ps_status;
+
+/*
+ * Always fill with ps_config_init. struct_size records the layout the
+ * caller was built against; ps_create rejects any size but the current
+ * sizeof(ps_config).
+ */
+typedef struct ps_config {
+    size_t struct_size;  /* sizeof(ps_config), set by ps_config_init */
+    size_t particle_count;
+    float gravity;
+    float initial_speed;
+    float air_friction;
+    float min_radius;
+    float max_radius;
+    int dimensions;      /* 2 or 3; 3D runs do not support compressed storage */
+    uint32_t seed;       /* 0 picks a random seed; equal seeds give equal runs */
+} ps_config;
+
+typedef enum ps_solver_mode {
+    PS_SOLVER_COLORED = 0,   /* parallel, one contact color at a time */
+    PS_SOLVER_SERIAL = 1     /* reference: contacts in detection order */
+} ps_solver_mode;
+
+typedef struct ps_array_view {
+    const float* data;
+    size_t count;        /* number of particles */
+    size_t stride;       /* bytes between consecutive particles */
+    size_t components;   /* floats per particle: x, y (and z in 3D) for vectors */
+} ps_array_view;
+
+typedef struct ps_flag_view {
+    const unsigned char* data;   /* nonzero while the slot holds a live particle */
+    size_t count;
+    size_t stride;
+} ps_flag_view;
+
+typedef struct ps_emitter {
+    float x, y;
+    float velocity_x, velocity_y;
+    float spread;   /* random +-spread added to each velocity component */
+    float rate;     /* particles per second */
+    float radius;   /* at most ps_config.max_radius */
+} ps_emitter;
+
+typedef struct ps_sink {
+    float left, bottom, right, top;
+} ps_sink;
+
+/* Fills config with the same defaults as the particle_sim viewer. */
+void ps_config_init(ps_config* config);
+
+ps_status ps_create(const ps_config* config, ps_simulation** out);
+void ps_destroy(ps_simulation* sim);
+ps_status ps_step(ps_simulation* sim, float delta_time);
+
+ps_status ps_set_gravity(ps_simulation* sim, float gravity);
+ps_status ps_set_air_friction(ps_simulation* sim, float air_friction);
+/* Results do not depend on the thread count. */
+ps_status ps_set_thread_count(ps_simulation* sim, size_t thread_count);
+/* Workers are pinned to CPUs unless enabled is 0. */
+ps_status ps_set_thread_pinning(ps_simulation* sim, int enabled);
+ps_status ps_set_solver_iterations(ps_simulation* sim, int iterations);
+ps_status ps_set_solver_mode(ps_simulation* sim, ps_solver_mode mode);
+
+/* Emitters and sinks need fp32 storage; emitters stall while the pool is full. */
+ps_status ps_set_particle_capacity(ps_simulation* sim, size_t capacity);
+ps_status ps_add_emitter(ps_simulation* sim, const ps_emitter* emitter);
+ps_status ps_add_sink(ps_simulation* sim, const ps_sink* sink);
+ps_status ps_get_live_count(const ps_simulation* sim, size_t* out);
+
+ps_status ps_get_positions(const ps_simulation* sim, ps_array_view* out);
+ps_status ps_get_velocities(const ps_simulation* sim, ps_array_view* out);
+ps_status ps_get_radii(const ps_simulation* sim, ps_array_view* out);
+ps_status ps_get_alive(const ps_simulation* sim, ps_flag_view* out);
+
+const char* ps_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PARTICLESIM_H */
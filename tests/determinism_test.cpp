@@ -0,0 +1,120 @@
+// Runs the same seeded scene headless with one and with several worker
+// threads through the C API and checks the final state matches bit for bit.
+#include "particlesim.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t SEED = 12345;
+constexpr int FRAMES = 120;
+constexpr size_t MANY_THREADS = 5;
+
+struct Scene {
+    int dimensions;
+    ps_solver_mode solver;
+    bool pool;   // Emitter and sink churning the particle pool
+};
+
+// Raw bytes of every per-particle view, in index order
+struct Snapshot {
+    std::vector<unsigned char> bytes;
+    size_t count = 0;
+};
+
+bool check(ps_status status, const char* what) {
+    if (status != PS_OK) {
+        std::cerr << what << " failed: " << ps_last_error() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void append(Snapshot& out, const void* data, size_t count, size_t stride, size_t bytes) {
+    const unsigned char* base = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < count; ++i) {
+        out.bytes.insert(out.bytes.end(), base + i * stride, base + i * stride + bytes);
+    }
+}
+
+bool run(const Scene& scene, size_t threads, Snapshot& out) {
+    ps_config config;
+    ps_config_init(&config);
+    config.particle_count = 2000;
+    config.min_radius = 0.1f;
+    config.max_radius = 0.4f;
+    config.dimensions = scene.dimensions;
+    config.seed = SEED;
+
+    ps_simulation* sim = nullptr;
+    if (!check(ps_create(&config, &sim), "ps_create")) return false;
+
+    bool ok = check(ps_set_thread_count(sim, threads), "ps_set_thread_count") &&
+              check(ps_set_solver_mode(sim, scene.solver), "ps_set_solver_mode");
+    if (ok && scene.pool) {
+        ps_emitter emitter = {-9.0f, 8.0f, 6.0f, 0.0f, 0.5f, 120.0f, 0.2f};
+        ps_sink sink = {7.0f, -10.0f, 13.4f, -6.0f};
+        ok = check(ps_set_particle_capacity(sim, 3000), "ps_set_particle_capacity") &&
+             check(ps_add_emitter(sim, &emitter), "ps_add_emitter") &&
+             check(ps_add_sink(sim, &sink), "ps_add_sink");
+    }
+    for (int frame = 0; ok && frame < FRAMES; ++frame) {
+        ok = check(ps_step(sim, 1.0f / 60.0f), "ps_step");
+    }
+
+    ps_array_view positions, velocities, radii;
+    ps_flag_view alive;
+    ok = ok && check(ps_get_positions(sim, &positions), "ps_get_positions") &&
+         check(ps_get_velocities(sim, &velocities), "ps_get_velocities") &&
+         check(ps_get_radii(sim, &radii), "ps_get_radii") &&
+         check(ps_get_alive(sim, &alive), "ps_get_alive");
+    if (ok) {
+        out = Snapshot();
+        out.count = positions.count;
+        for (const ps_array_view* view : {&positions, &velocities, &radii}) {
+            append(out, view->data, view->count, view->stride, view->components * sizeof(float));
+        }
+        append(out, alive.data, alive.count, alive.stride, 1);
+    }
+
+    ps_destroy(sim);
+    return ok;
+}
+
+std::string describe(const Scene& scene) {
+    return std::to_string(scene.dimensions) + "D " +
+           (scene.solver == PS_SOLVER_COLORED ? "colored" : "serial") +
+           (scene.pool ? " with emitter and sink" : "");
+}
+
+}  // namespace
+
+int main() {
+    const Scene scenes[] = {
+        {2, PS_SOLVER_COLORED, false},
+        {2, PS_SOLVER_SERIAL, false},
+        {2, PS_SOLVER_COLORED, true},
+        {3, PS_SOLVER_COLORED, false},
+        {3, PS_SOLVER_COLORED, true},
+    };
+
+    int failures = 0;
+    for (const Scene& scene : scenes) {
+        Snapshot single, repeated, parallel;
+        bool ran = run(scene, 1, single) && run(scene, 1, repeated) &&
+                   run(scene, MANY_THREADS, parallel);
+        bool reproducible = ran && single.bytes == repeated.bytes;
+        bool threadIndependent = ran && single.count == parallel.count &&
+                                 single.bytes == parallel.bytes;
+
+        std::cout << describe(scene) << ": "
+                  << (!ran ? "failed to run"
+                      : !reproducible ? "differs between identical runs"
+                      : !threadIndependent ? "differs between 1 and " + std::to_string(MANY_THREADS) + " threads"
+                      : "ok")
+                  << std::endl;
+        if (!threadIndependent || !reproducible) ++failures;
+    }
+    return failures == 0 ? 0 : 1;
+}